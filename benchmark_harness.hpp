@@ -0,0 +1,413 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+// Benchmark harness: adaptive sampling until a target relative error,
+// summary statistics with confidence intervals and outlier counts, CPU
+// pinning, and an optimization barrier for benchmark results.
+
+// Sampling policy shared by every benchmark in a run
+struct RunnerConfig {
+    int warmup_runs = 1;
+    size_t min_samples = 5;
+    size_t max_samples = 50;
+    double target_rel_error = 0.01;  // 95% CI half-width relative to the mean
+    double max_time_ms = 3000.0;     // Wall-clock budget per benchmark, setup included
+};
+
+inline RunnerConfig& runner_config() {
+    static RunnerConfig config;
+    return config;
+}
+
+// Keep the compiler from discarding a computed value or the work feeding it
+template <typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    const volatile char* p = reinterpret_cast<const volatile char*>(&value);
+    (void)*p;
+#endif
+}
+
+// Force pending memory writes to be treated as observable
+inline void clobber_memory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+}
+
+// Pin the calling thread to one CPU. Returns false where unsupported.
+inline bool pin_to_cpu(int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// CPU the calling thread is running on, or -1 if unknown
+inline int current_cpu() {
+#if defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+// Timer utility (steady clock, nanosecond resolution)
+class Timer {
+    std::chrono::steady_clock::time_point start_;
+public:
+    Timer() : start_(std::chrono::steady_clock::now()) {}
+
+    double elapsed_ms() const {
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start_).count();
+    }
+};
+
+// Resident set size of this process in bytes (0 where unsupported)
+inline size_t current_rss_bytes() {
+#if defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    if (statm >> total_pages >> resident_pages) {
+        return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+#endif
+    return 0;
+}
+
+// Reset the peak RSS high-water mark to the current RSS. Returns false
+// where unsupported (peak_rss_bytes() then reports the lifetime peak).
+inline bool reset_peak_rss() {
+#if defined(__linux__)
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.flush();
+    return static_cast<bool>(clear_refs);
+#else
+    return false;
+#endif
+}
+
+// Peak resident set size of this process in bytes (0 where unsupported)
+inline size_t peak_rss_bytes() {
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return static_cast<size_t>(std::stoull(line.substr(6))) * 1024;
+        }
+    }
+#endif
+    return 0;
+}
+
+// Log-bucketed latency histogram: exact below 16 ns, then 8 buckets per
+// power of two (12.5% resolution). Recording is a handful of instructions.
+class LatencyHistogram {
+    static constexpr size_t bucket_count = 16 + 60 * 8;
+    std::array<uint64_t, bucket_count> counts_{};
+    uint64_t total_ = 0;
+
+    static size_t bucket(uint64_t ns) {
+        if (ns < 16) {
+            return static_cast<size_t>(ns);
+        }
+        int msb = 0;
+        for (uint64_t v = ns; v > 1; v >>= 1) {
+            msb++;
+        }
+        return 16 + static_cast<size_t>(msb - 4) * 8 + static_cast<size_t>((ns >> (msb - 3)) & 7);
+    }
+
+    // Smallest value that maps to the bucket
+    static uint64_t bucket_floor(size_t index) {
+        if (index < 16) {
+            return index;
+        }
+        size_t msb = (index - 16) / 8 + 4;
+        uint64_t sub = (index - 16) % 8;
+        return (8 + sub) << (msb - 3);
+    }
+
+public:
+    void record(uint64_t ns) {
+        counts_[bucket(ns)]++;
+        total_++;
+    }
+
+    uint64_t count() const { return total_; }
+
+    void clear() {
+        counts_.fill(0);
+        total_ = 0;
+    }
+
+    // Approximate q-quantile in nanoseconds, q in [0, 1]
+    uint64_t percentile(double q) const {
+        if (total_ == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(total_)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; i++) {
+            seen += counts_[i];
+            if (seen >= rank && counts_[i] > 0) {
+                return bucket_floor(i);
+            }
+        }
+        return bucket_floor(bucket_count - 1);
+    }
+};
+
+// Summary of one benchmark's samples (all times in milliseconds)
+struct SampleStats {
+    size_t samples = 0;
+    double mean = 0;
+    double median = 0;
+    double stddev = 0;
+    double min = 0;
+    double max = 0;
+    double ci_low = 0;   // 95% confidence interval of the mean
+    double ci_high = 0;
+    size_t outliers_low = 0;   // Beyond the Tukey fences (1.5 IQR)
+    size_t outliers_high = 0;
+
+    double rel_error() const {
+        return mean > 0 ? (ci_high - mean) / mean : 0;
+    }
+};
+
+// Two-sided 95% Student t critical value
+inline double t_critical_95(size_t df) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df == 0) {
+        return 0;
+    }
+    if (df <= 30) {
+        return table[df - 1];
+    }
+    return 1.96 + 2.37 / static_cast<double>(df);  // Cornish-Fisher correction
+}
+
+// Linearly interpolated quantile of sorted values, q in [0, 1]
+inline double quantile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    double pos = q * static_cast<double>(sorted.size() - 1);
+    size_t lo = static_cast<size_t>(pos);
+    size_t hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - static_cast<double>(lo));
+}
+
+inline SampleStats summarize(std::vector<double> samples) {
+    SampleStats stats;
+    stats.samples = samples.size();
+    if (samples.empty()) {
+        return stats;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    double sum = 0;
+    for (double s : samples) {
+        sum += s;
+    }
+    stats.mean = sum / static_cast<double>(samples.size());
+
+    double sq = 0;
+    for (double s : samples) {
+        sq += (s - stats.mean) * (s - stats.mean);
+    }
+    stats.stddev = samples.size() > 1 ? std::sqrt(sq / static_cast<double>(samples.size() - 1)) : 0;
+
+    stats.median = quantile(samples, 0.5);
+    stats.min = samples.front();
+    stats.max = samples.back();
+
+    double half_width = t_critical_95(samples.size() - 1) * stats.stddev /
+                        std::sqrt(static_cast<double>(samples.size()));
+    stats.ci_low = stats.mean - half_width;
+    stats.ci_high = stats.mean + half_width;
+
+    double q1 = quantile(samples, 0.25);
+    double q3 = quantile(samples, 0.75);
+    double iqr = q3 - q1;
+    for (double s : samples) {
+        if (s < q1 - 1.5 * iqr) stats.outliers_low++;
+        if (s > q3 + 1.5 * iqr) stats.outliers_high++;
+    }
+    return stats;
+}
+
+// Benchmark result structure
+struct BenchmarkResult {
+    std::string name;
+    double time_ms;  // Median sample
+    size_t operations;
+    SampleStats stats;
+    std::vector<double> samples_ms;
+
+    double ops_per_sec() const {
+        return operations / (time_ms / 1000.0);
+    }
+};
+
+// Run sample() until the mean's 95% CI is within the target relative error
+// (bounded by min/max samples and the time budget). sample() performs any
+// untimed setup itself and returns the timed portion in milliseconds.
+template <typename Sample>
+BenchmarkResult measure(const std::string& name, size_t operations, Sample sample) {
+    const RunnerConfig& config = runner_config();
+    for (int i = 0; i < config.warmup_runs; i++) {
+        sample();
+    }
+
+    std::vector<double> samples;
+    Timer budget;
+    while (samples.size() < config.max_samples) {
+        samples.push_back(sample());
+        if (samples.size() < config.min_samples) {
+            continue;
+        }
+        if (budget.elapsed_ms() >= config.max_time_ms ||
+            summarize(samples).rel_error() <= config.target_rel_error) {
+            break;
+        }
+    }
+
+    SampleStats stats = summarize(samples);
+    return {name, stats.median, operations, stats, std::move(samples)};
+}
+
+// Every printed result is also recorded with the group (section) and data
+// size it was run under, so a run can be written out as JSON and compared
+// against another run with btree_compare.
+struct RecordedResult {
+    std::string group;
+    size_t size;
+    BenchmarkResult result;
+};
+
+struct ResultLog {
+    std::string group;
+    size_t size = 0;
+    std::vector<RecordedResult> results;
+};
+
+inline ResultLog& result_log() {
+    static ResultLog log;
+    return log;
+}
+
+// Start a new section of results (printed as "=== title ===")
+inline void begin_group(const std::string& title) {
+    result_log().group = title;
+    std::cout << "\n=== " << title << " ===\n";
+}
+
+inline void set_benchmark_size(size_t n) {
+    result_log().size = n;
+}
+
+inline std::string json_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+// Write all recorded results, including raw samples, as JSON
+inline bool write_results_json(const std::string& path, int cpu) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    const RunnerConfig& config = runner_config();
+    out << std::setprecision(9);
+    out << "{\n  \"context\": {\"cpu\": " << cpu
+        << ", \"min_samples\": " << config.min_samples
+        << ", \"max_samples\": " << config.max_samples
+        << ", \"target_rel_error\": " << config.target_rel_error
+        << ", \"max_time_ms\": " << config.max_time_ms << "},\n";
+    out << "  \"results\": [";
+    const auto& results = result_log().results;
+    for (size_t i = 0; i < results.size(); i++) {
+        const RecordedResult& rec = results[i];
+        const BenchmarkResult& r = rec.result;
+        out << (i == 0 ? "\n" : ",\n")
+            << "    {\"group\": \"" << json_escape(rec.group) << "\""
+            << ", \"name\": \"" << json_escape(r.name) << "\""
+            << ", \"size\": " << rec.size
+            << ", \"operations\": " << r.operations
+            << ", \"median_ms\": " << r.stats.median
+            << ", \"mean_ms\": " << r.stats.mean
+            << ", \"stddev_ms\": " << r.stats.stddev
+            << ", \"ci_low_ms\": " << r.stats.ci_low
+            << ", \"ci_high_ms\": " << r.stats.ci_high
+            << ", \"outliers\": " << r.stats.outliers_low + r.stats.outliers_high
+            << ", \"samples_ms\": [";
+        for (size_t j = 0; j < r.samples_ms.size(); j++) {
+            out << (j == 0 ? "" : ", ") << r.samples_ms[j];
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+// Print result: median, CI half-width relative to the mean, throughput at the median
+inline void print_result(const BenchmarkResult& r) {
+    std::ostringstream ci;
+    ci << "+/-" << std::fixed << std::setprecision(1) << r.stats.rel_error() * 100 << "%";
+
+    std::cout << std::left << std::setw(40) << r.name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(2) << r.time_ms << " ms"
+              << std::setw(9) << ci.str()
+              << std::setw(15) << static_cast<long>(r.ops_per_sec()) << " ops/sec"
+              << "  n=" << r.stats.samples;
+    size_t outliers = r.stats.outliers_low + r.stats.outliers_high;
+    if (outliers > 0) {
+        std::cout << " (" << outliers << " outlier" << (outliers > 1 ? "s" : "") << ")";
+    }
+    std::cout << "\n";
+
+    ResultLog& log = result_log();
+    log.results.push_back({log.group, log.size, r});
+}
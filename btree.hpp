@@ -3,9 +3,388 @@
 #include <iostream>
 #include <vector>
 #include <stack>
+#include <deque>
 #include <stdexcept>
 #include <functional>
 #include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <thread>
+#include <exception>
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <charconv>
+#include <sstream>
+
+namespace btree_detail {
+
+// Node-search kernels shared by BTree and StaticBTree: index of the first key
+// in keys[0, count) that is not less than (lower) or greater than (upper) key.
+// constexpr so that frozen trees can be queried at compile time. The less
+// overloads let callers observe each probe (e.g. to count comparisons).
+template <typename T, typename Less>
+constexpr size_t lower_bound_index(const T* keys, size_t count, const T& key, Less less) {
+    size_t first = 0;
+    while (count > 0) {
+        size_t half = count / 2;
+        if (less(keys[first + half], key)) {
+            first += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+    return first;
+}
+
+template <typename T, typename Less>
+constexpr size_t upper_bound_index(const T* keys, size_t count, const T& key, Less less) {
+    size_t first = 0;
+    while (count > 0) {
+        size_t half = count / 2;
+        if (!less(key, keys[first + half])) {
+            first += half + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+    return first;
+}
+
+template <typename T>
+constexpr size_t lower_bound_index(const T* keys, size_t count, const T& key) {
+    return lower_bound_index(keys, count, key, [](const T& a, const T& b) { return a < b; });
+}
+
+template <typename T>
+constexpr size_t upper_bound_index(const T* keys, size_t count, const T& key) {
+    return upper_bound_index(keys, count, key, [](const T& a, const T& b) { return a < b; });
+}
+
+// Distinct 64-byte cache lines covered by a set of byte ranges (small sets)
+class CacheLineSet {
+    uintptr_t lines_[96];
+    size_t count_ = 0;
+
+public:
+    // Adds the lines spanned by [address, address + bytes); returns how many were new
+    size_t add(const void* address, size_t bytes) noexcept {
+        uintptr_t first = reinterpret_cast<uintptr_t>(address) / 64;
+        uintptr_t last = (reinterpret_cast<uintptr_t>(address) + (bytes == 0 ? 0 : bytes - 1)) / 64;
+        size_t added = 0;
+        for (uintptr_t line = first; line <= last; line++) {
+            if (std::find(lines_, lines_ + count_, line) == lines_ + count_ && count_ < 96) {
+                lines_[count_++] = line;
+                added++;
+            }
+        }
+        return added;
+    }
+};
+
+}  // namespace btree_detail
+
+// Fixed-capacity string key stored inline in the node's key array.
+//
+// std::string keys live behind an SSO/heap indirection and compare through
+// std::string::compare. FixedString<N> keeps up to N bytes inline with the
+// unused tail zeroed, so ordering is a single fixed-length memcmp over the
+// whole buffer, which compilers lower to a few vector loads for small N.
+// Zero padding gives the same order as std::string for keys without
+// embedded NUL bytes; the stored length breaks the remaining ties.
+//
+// Pick N so that sizeof(FixedString<N>) == N + 1 is a round size, e.g.
+// FixedString<23> occupies 24 bytes and FixedString<31> occupies 32 bytes.
+template <size_t N>
+class FixedString {
+    static_assert(N > 0 && N < 256, "FixedString capacity must be in [1, 255]");
+
+    char data_[N];
+    unsigned char size_;
+
+public:
+    FixedString() noexcept : data_{}, size_(0) {}
+
+    // Throws std::length_error if the value does not fit in N bytes
+    FixedString(std::string_view value) : data_{}, size_(0) {
+        if (value.size() > N) {
+            throw std::length_error("FixedString capacity exceeded");
+        }
+        std::memcpy(data_, value.data(), value.size());
+        size_ = static_cast<unsigned char>(value.size());
+    }
+
+    FixedString(const char* value) : FixedString(std::string_view(value)) {}
+    FixedString(const std::string& value) : FixedString(std::string_view(value)) {}
+
+    [[nodiscard]] static constexpr size_t capacity() noexcept { return N; }
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] const char* data() const noexcept { return data_; }
+
+    [[nodiscard]] std::string_view view() const noexcept {
+        return std::string_view(data_, size_);
+    }
+
+    [[nodiscard]] std::string str() const {
+        return std::string(data_, size_);
+    }
+
+    friend bool operator==(const FixedString& a, const FixedString& b) noexcept {
+        return a.size_ == b.size_ && std::memcmp(a.data_, b.data_, N) == 0;
+    }
+
+    friend bool operator!=(const FixedString& a, const FixedString& b) noexcept {
+        return !(a == b);
+    }
+
+    friend bool operator<(const FixedString& a, const FixedString& b) noexcept {
+        int cmp = std::memcmp(a.data_, b.data_, N);
+        return cmp < 0 || (cmp == 0 && a.size_ < b.size_);
+    }
+
+    friend bool operator>(const FixedString& a, const FixedString& b) noexcept { return b < a; }
+    friend bool operator<=(const FixedString& a, const FixedString& b) noexcept { return !(b < a); }
+    friend bool operator>=(const FixedString& a, const FixedString& b) noexcept { return !(a < b); }
+
+    friend std::ostream& operator<<(std::ostream& os, const FixedString& s) {
+        return os << s.view();
+    }
+};
+
+namespace std {
+template <size_t N>
+struct hash<FixedString<N>> {
+    size_t operator()(const FixedString<N>& s) const noexcept {
+        return hash<string_view>()(s.view());
+    }
+};
+}  // namespace std
+
+namespace btree_detail {
+
+// Text form of one key for BTree::dump_text()/load_text(): append() writes
+// it without the line break, parse() reads a whole line and fails unless
+// every character is used. Streams handle key types without a faster path.
+template <typename T, typename = void>
+struct TextKey {
+    static void append(std::string& out, const T& key) {
+        std::ostringstream text;
+        text << key;
+        out += text.str();
+    }
+
+    static bool parse(std::string_view line, T& key) {
+        std::istringstream text{std::string(line)};
+        return static_cast<bool>(text >> key) && text.peek() == std::char_traits<char>::eof();
+    }
+};
+
+// Numbers: std::to_chars/std::from_chars (shortest round-trip form for
+// floating point, no locale)
+template <typename T>
+struct TextKey<T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>> {
+    static void append(std::string& out, const T& key) {
+        char digits[64];
+        auto result = std::to_chars(digits, digits + sizeof(digits), key);
+        out.append(digits, result.ptr);
+    }
+
+    static bool parse(std::string_view line, T& key) {
+        auto result = std::from_chars(line.data(), line.data() + line.size(), key);
+        return result.ec == std::errc() && result.ptr == line.data() + line.size();
+    }
+};
+
+// Strings: the line itself, so keys cannot contain a line break
+template <typename S>
+struct TextString {
+    static void append(std::string& out, const S& key) {
+        std::string_view view(key);
+        if (view.find('\n') != std::string_view::npos) {
+            throw std::invalid_argument("dump_text: key contains a line break");
+        }
+        out += view;
+    }
+};
+
+template <>
+struct TextKey<std::string> : TextString<std::string> {
+    static bool parse(std::string_view line, std::string& key) {
+        key.assign(line);
+        return true;
+    }
+};
+
+template <size_t N>
+struct TextKey<FixedString<N>> {
+    static void append(std::string& out, const FixedString<N>& key) {
+        TextString<std::string_view>::append(out, key.view());
+    }
+
+    static bool parse(std::string_view line, FixedString<N>& key) {
+        if (line.size() > N) {
+            return false;
+        }
+        key = FixedString<N>(line);
+        return true;
+    }
+};
+
+// Inline sample array of a BTree node (see BTreeNodeIndex); empty when
+// the index is off, so the node keeps its layout
+template <typename T, size_t N>
+struct NodeSamples {
+    std::array<T, N> samples{};
+};
+
+template <typename T>
+struct NodeSamples<T, 0> {};
+
+}  // namespace btree_detail
+
+// Order whose key array fills about NodeBytes bytes, for sizing nodes around
+// inline keys such as FixedString. Rounded down to an even order (odd orders
+// take the merge-overflow path in remove()) and never below 4.
+template <typename T, size_t NodeBytes = 256>
+inline constexpr int node_order_for = [] {
+    size_t order = NodeBytes / sizeof(T) + 1;
+    order -= order % 2;
+    return static_cast<int>(order < 4 ? 4 : order);
+}();
+
+// Sampled sub-index inside each BTree<T, Order> node: `samples` copies of
+// every k-th key (k = ceil((Order - 1) / (samples + 1))) stored inline in
+// the node, so a search first counts the samples below the key in that
+// small array, which shares cache lines with the node header, and then
+// scans one block of k keys instead of the whole key array. Every key
+// change in a node rewrites its samples.
+//
+// Off (samples = 0) unless specialized. It pays off for page-sized nodes
+// (orders >= 256) with arithmetic keys; two cache lines of samples
+// (128 / sizeof(T)) is a good start.
+template <typename T, int Order, typename = void>
+struct BTreeNodeIndex {
+    static constexpr size_t samples = 0;
+};
+
+// How insert() makes room in a full child (see BTree::set_split_policy()).
+// Even splits it into two half-full nodes, leaving random inserts about 69%
+// full. Redistribute (B*-tree style) first rotates keys into an adjacent
+// sibling with room, and splits two full siblings into three nodes about
+// 2/3 full, which keeps nodes around 80% full at the price of more key
+// moves per insert.
+enum class SplitPolicy { Even, Redistribute };
+
+// When insert() splits full nodes (see BTree::set_insert_strategy()).
+// Preemptive splits every full node met on the way down, so the descent
+// never backtracks but splits internal nodes the key never needed room in.
+// BottomUp descends first and splits only when the leaf is full, and then
+// only the run of full nodes directly above it.
+enum class InsertStrategy { Preemptive, BottomUp };
+
+// Operation counters and latency histograms for a BTree (see
+// BTree::set_metrics()). Everything is a relaxed atomic, so recording is
+// cheap, any number of threads may record at once, and a reader may sample
+// while they do. Every operation is counted; one in latency_sample_every
+// is timed. btree_prometheus.hpp renders the result.
+class BTreeMetrics {
+public:
+    enum Op { Insert, Remove, Search, op_count };
+
+    // Upper bounds of the finite latency buckets, in nanoseconds
+    static constexpr uint64_t bucket_bounds_ns[] = {100, 250, 500, 1000, 2500, 5000,
+                                                    10000, 25000, 50000, 100000, 1000000};
+    static constexpr size_t bucket_count = sizeof(bucket_bounds_ns) / sizeof(bucket_bounds_ns[0]);
+
+    struct Histogram {
+        std::atomic<uint64_t> buckets[bucket_count + 1] = {};  // Per bucket (not cumulative); last is +Inf
+        std::atomic<uint64_t> sum_ns{0};
+        std::atomic<uint64_t> count{0};
+    };
+
+    explicit BTreeMetrics(uint32_t latency_sample_every = 16)
+        : sample_every_(latency_sample_every == 0 ? 1 : latency_sample_every) {}
+
+    BTreeMetrics(const BTreeMetrics&) = delete;
+    BTreeMetrics& operator=(const BTreeMetrics&) = delete;
+
+    uint64_t operations(Op op) const noexcept { return ops_[op].load(std::memory_order_relaxed); }
+    uint64_t splits() const noexcept { return splits_.load(std::memory_order_relaxed); }
+    uint64_t merges() const noexcept { return merges_.load(std::memory_order_relaxed); }
+    uint64_t borrows() const noexcept { return borrows_.load(std::memory_order_relaxed); }
+    const Histogram& latency(Op op) const noexcept { return latency_[op]; }
+    uint32_t latency_sample_every() const noexcept { return sample_every_; }
+
+    static const char* op_name(Op op) noexcept {
+        static const char* const names[] = {"insert", "remove", "search"};
+        return names[op];
+    }
+
+    // Counts one operation and times it if it is sampled
+    class Scope {
+        BTreeMetrics* metrics_;
+        Op op_;
+        std::chrono::steady_clock::time_point start_;
+        bool timed_ = false;
+
+    public:
+        Scope(BTreeMetrics* metrics, Op op) noexcept : metrics_(metrics), op_(op) {
+            if (metrics_ != nullptr &&
+                metrics_->ops_[op].fetch_add(1, std::memory_order_relaxed) % metrics_->sample_every_ == 0) {
+                timed_ = true;
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+
+        ~Scope() {
+            if (timed_) {
+                auto elapsed = std::chrono::steady_clock::now() - start_;
+                metrics_->record_latency(op_, static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    void record_latency(Op op, uint64_t ns) noexcept {
+        size_t bucket = 0;
+        while (bucket < bucket_count && ns > bucket_bounds_ns[bucket]) {
+            bucket++;
+        }
+        Histogram& histogram = latency_[op];
+        histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        histogram.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+        histogram.count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void count_split() noexcept { splits_.fetch_add(1, std::memory_order_relaxed); }
+    void count_merge() noexcept { merges_.fetch_add(1, std::memory_order_relaxed); }
+    void count_borrow() noexcept { borrows_.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    const uint32_t sample_every_;
+    std::atomic<uint64_t> ops_[op_count] = {};
+    std::atomic<uint64_t> splits_{0};
+    std::atomic<uint64_t> merges_{0};
+    std::atomic<uint64_t> borrows_{0};
+    Histogram latency_[op_count];
+};
+
+// Access to BTree internals (nodes and rebalancing primitives) for
+// benchmarks and tests. Specialize for BTree<T, Order>; not part of the
+// public API.
+template <typename Tree>
+struct BTreeInspector;
 
 // B-tree implementation with configurable order.
 //
@@ -21,10 +400,15 @@
 template <typename T, int Order = 3>
 class BTree {
 private:
-    struct Node {
+    static constexpr size_t index_samples = BTreeNodeIndex<T, Order>::samples;
+    static constexpr size_t index_stride =
+        index_samples == 0 ? 0 : (static_cast<size_t>(Order - 1) + index_samples) / (index_samples + 1);
+
+    struct Node : btree_detail::NodeSamples<T, index_samples> {
         std::vector<T> keys;
         std::vector<Node*> children;
         bool is_leaf;
+        mutable std::atomic<uint32_t> visits{0};  // Profiling counter (fits in the padding after is_leaf)
 
         Node(bool leaf = true) : is_leaf(leaf) {
             // Pre-allocate to avoid reallocations during node filling
@@ -34,6 +418,10 @@ private:
             }
         }
 
+        // Owns its children through raw pointers
+        Node(const Node&) = delete;
+        Node& operator=(const Node&) = delete;
+
         ~Node() {
             for (Node* child : children) {
                 delete child;
@@ -43,9 +431,16 @@ private:
 
     Node* root;
     size_t size_;
+    bool profiling_ = false;
+    SplitPolicy split_policy_ = SplitPolicy::Even;
+    InsertStrategy insert_strategy_ = InsertStrategy::Preemptive;
+    BTreeMetrics* metrics_ = nullptr;
     static constexpr int max_keys = Order - 1;
     static constexpr int min_keys = (Order - 1) / 2;
 
+    template <typename Tree>
+    friend struct BTreeInspector;
+
 public:
     // Forward iterator for in-order traversal
     class iterator {
@@ -139,7 +534,225 @@ public:
 
     using const_iterator = iterator;  // All iterators are const (keys are immutable)
 
+    // Structural statistics gathered by walking every node (see stats())
+    struct Stats {
+        size_t nodes = 0;
+        size_t leaf_nodes = 0;
+        size_t internal_nodes = 0;
+        size_t keys = 0;
+        size_t height = 0;
+        size_t memory_bytes = 0;  // Node objects plus reserved key/child storage
+
+        // Fraction of key slots in use across all nodes
+        double average_fill() const noexcept {
+            return nodes == 0 ? 0.0 : static_cast<double>(keys) / (static_cast<double>(nodes) * max_keys);
+        }
+    };
+
+    // Node visit counts gathered while profiling is enabled (see heatmap())
+    struct Heatmap {
+        struct Level {
+            size_t nodes = 0;
+            size_t cold_nodes = 0;  // Never visited
+            uint64_t visits = 0;
+        };
+
+        // Subtree rooted at `depth`, covering keys [first, last]
+        struct Subtree {
+            size_t depth = 0;
+            T first{};
+            T last{};
+            size_t nodes = 0;
+            uint64_t visits = 0;   // Sum over every node in the subtree
+            double share = 0.0;    // visits / total visits of subtrees at this depth
+        };
+
+        std::vector<Level> levels;      // Root first
+        std::vector<Subtree> hottest;   // Most visited subtrees, descending
+        size_t subtree_count = 0;       // Subtrees ranked at hottest's depth
+        double top_decile_share = 0.0;  // Traffic share of the hottest 10% of those subtrees
+        uint64_t visits = 0;
+        size_t memory_bytes = 0;
+        size_t cold_bytes = 0;          // Memory of nodes never visited
+
+        double cold_fraction() const noexcept {
+            return memory_bytes == 0 ? 0.0 : static_cast<double>(cold_bytes) / static_cast<double>(memory_bytes);
+        }
+    };
+
+    // Work done by the calls given this context (see the OpCost overloads
+    // of search, find, insert and remove); each call adds to the counts
+    struct OpCost {
+        size_t nodes_visited = 0;
+        size_t comparisons = 0;    // Key comparisons, including equality checks
+        size_t bytes_touched = 0;  // Node headers, probed keys and followed child pointers
+        size_t cache_lines = 0;    // Distinct 64-byte lines among those bytes, per node visit
+        size_t splits = 0;
+        size_t merges = 0;
+        size_t borrows = 0;        // Rotations of keys between siblings through the parent
+
+        size_t rebalance_steps() const noexcept {
+            return splits + merges + borrows;
+        }
+    };
+
 private:
+    OpCost* cost_ = nullptr;  // Set while an insert or remove with an OpCost runs
+
+    static size_t lower_index(const Node* node, const T& key, OpCost* cost = nullptr) {
+        if (cost != nullptr) {
+            return counted_index<false>(node, key, *cost);
+        }
+        return bound_index<false>(node, key, [](const T& a, const T& b) { return a < b; });
+    }
+
+    static size_t upper_index(const Node* node, const T& key, OpCost* cost = nullptr) {
+        if (cost != nullptr) {
+            return counted_index<true>(node, key, *cost);
+        }
+        return bound_index<true>(node, key, [](const T& a, const T& b) { return a < b; });
+    }
+
+    // Lower or upper bound of key in node->keys. With the sampled index the
+    // samples pick the block of index_stride keys holding the bound (the
+    // last block takes whatever the samples do not cover); both are scanned
+    // by counting the keys before the bound, which has no data-dependent
+    // branches and vectorizes for arithmetic keys.
+    template <bool Upper, typename Less>
+    static size_t bound_index(const Node* node, const T& key, Less less) {
+        const T* keys = node->keys.data();
+        size_t count = node->keys.size();
+        if constexpr (index_samples > 0) {
+            auto before = [&](const T& k) { return Upper ? !less(key, k) : less(k, key); };
+            size_t sampled = std::min(index_samples, count / index_stride);
+            size_t block = 0;
+            for (size_t j = 0; j < sampled; j++) {
+                block += before(node->samples[j]) ? 1 : 0;
+            }
+            size_t first = block * index_stride;
+            size_t last = block < sampled ? first + index_stride : count;
+            if (last - first > 2 * index_stride) {
+                // Oversized tail (a node being grown by parallel_insert_batch)
+                return first + (Upper ? btree_detail::upper_bound_index(keys + first, last - first, key, less)
+                                      : btree_detail::lower_bound_index(keys + first, last - first, key, less));
+            }
+            for (size_t i = first; i < last; i++) {
+                first += before(keys[i]) ? 1 : 0;
+            }
+            return first;
+        } else {
+            return Upper ? btree_detail::upper_bound_index(keys, count, key, less)
+                         : btree_detail::lower_bound_index(keys, count, key, less);
+        }
+    }
+
+    // Rewrite node's samples after its keys changed; keys before position
+    // `from` must be unchanged
+    static void index_keys(Node* node, size_t from = 0) noexcept {
+        if constexpr (index_samples > 0) {
+            size_t sampled = std::min(index_samples, node->keys.size() / index_stride);
+            for (size_t j = from / index_stride; j < sampled; j++) {
+                node->samples[j] = node->keys[(j + 1) * index_stride - 1];
+            }
+        } else {
+            (void)node;
+            (void)from;
+        }
+    }
+
+    // Node search that records its comparisons, the keys it probes and the
+    // child pointer the caller will follow
+    template <bool Upper>
+    static size_t counted_index(const Node* node, const T& key, OpCost& cost) {
+        btree_detail::CacheLineSet lines;
+        lines.add(node, sizeof(Node));  // Counted by touch(), which also covers the samples
+        auto probe = [&](const T& k) {
+            cost.comparisons++;
+            std::less<const T*> before;
+            if (before(&k, node->keys.data()) || !before(&k, node->keys.data() + node->keys.size())) {
+                return;  // A sample inside the node
+            }
+            cost.bytes_touched += sizeof(T);
+            cost.cache_lines += lines.add(&k, sizeof(T));
+        };
+        size_t i;
+        if (Upper) {
+            i = bound_index<true>(node, key, [&](const T& a, const T& b) { probe(b); return a < b; });
+        } else {
+            i = bound_index<false>(node, key, [&](const T& a, const T& b) { probe(a); return a < b; });
+        }
+        if (!node->is_leaf) {
+            cost.bytes_touched += sizeof(Node*);
+            cost.cache_lines += lines.add(node->children.data() + i, sizeof(Node*));
+        }
+        return i;
+    }
+
+    // Whether keys[i] exists and equals key
+    static bool key_at(const Node* node, size_t i, const T& key, OpCost* cost) {
+        if (i >= node->keys.size()) {
+            return false;
+        }
+        if (cost != nullptr) {
+            cost->comparisons++;
+        }
+        return node->keys[i] == key;
+    }
+
+    // Counts a visit when profiling is on (saturating) and in cost. The
+    // counter is atomic because const readers, which may run concurrently
+    // under a shared lock, update it.
+    void touch(const Node* node, OpCost* cost = nullptr) const noexcept {
+        if (profiling_) {
+            uint32_t seen = node->visits.load(std::memory_order_relaxed);
+            while (seen != UINT32_MAX &&
+                   !node->visits.compare_exchange_weak(seen, seen + 1, std::memory_order_relaxed)) {
+            }
+        }
+        if (cost != nullptr) {
+            cost->nodes_visited++;
+            cost->bytes_touched += sizeof(Node);
+            cost->cache_lines += (reinterpret_cast<uintptr_t>(node) + sizeof(Node) - 1) / 64 -
+                                 reinterpret_cast<uintptr_t>(node) / 64 + 1;
+        }
+    }
+
+    // Rebalancing steps, reported to the active OpCost and the metrics
+    void note_split() noexcept {
+        if (cost_ != nullptr) {
+            cost_->splits++;
+        }
+        if (metrics_ != nullptr) {
+            metrics_->count_split();
+        }
+    }
+
+    void note_merge() noexcept {
+        if (cost_ != nullptr) {
+            cost_->merges++;
+        }
+        if (metrics_ != nullptr) {
+            metrics_->count_merge();
+        }
+    }
+
+    void note_borrow() noexcept {
+        if (cost_ != nullptr) {
+            cost_->borrows++;
+        }
+        if (metrics_ != nullptr) {
+            metrics_->count_borrow();
+        }
+    }
+
+    // Routes the rebalancing helpers' accounting to cost for one call
+    struct CostScope {
+        BTree& tree;
+        CostScope(BTree& t, OpCost& cost) noexcept : tree(t) { tree.cost_ = &cost; }
+        ~CostScope() { tree.cost_ = nullptr; }
+        CostScope(const CostScope&) = delete;
+        CostScope& operator=(const CostScope&) = delete;
+    };
 
     void split_child(Node* parent, size_t index) {
         Node* full_child = parent->children[index];
@@ -158,34 +771,219 @@ private:
 
         parent->keys.insert(parent->keys.begin() + index, mid_key);
         parent->children.insert(parent->children.begin() + index + 1, new_node);
+        index_keys(full_child);
+        index_keys(new_node);
+        index_keys(parent);
+        note_split();
+    }
+
+    // Rotate the last count keys of children[index] through the parent
+    // into the front of children[index + 1]
+    void shift_right(Node* parent, size_t index, size_t count) {
+        Node* left = parent->children[index];
+        Node* right = parent->children[index + 1];
+        size_t keep = left->keys.size() - count;
+
+        right->keys.insert(right->keys.begin(), std::move(parent->keys[index]));
+        right->keys.insert(right->keys.begin(), std::make_move_iterator(left->keys.begin() + keep + 1),
+                           std::make_move_iterator(left->keys.end()));
+        parent->keys[index] = std::move(left->keys[keep]);
+        left->keys.resize(keep);
+
+        if (!left->is_leaf) {
+            right->children.insert(right->children.begin(), left->children.begin() + keep + 1,
+                                   left->children.end());
+            left->children.resize(keep + 1);
+        }
+        index_keys(left);
+        index_keys(right);
+        index_keys(parent);
+        note_borrow();
+    }
+
+    // Rotate the first count keys of children[index + 1] through the
+    // parent onto the end of children[index]
+    void shift_left(Node* parent, size_t index, size_t count) {
+        Node* left = parent->children[index];
+        Node* right = parent->children[index + 1];
+
+        left->keys.push_back(std::move(parent->keys[index]));
+        left->keys.insert(left->keys.end(), std::make_move_iterator(right->keys.begin()),
+                          std::make_move_iterator(right->keys.begin() + count - 1));
+        parent->keys[index] = std::move(right->keys[count - 1]);
+        right->keys.erase(right->keys.begin(), right->keys.begin() + count);
+
+        if (!right->is_leaf) {
+            left->children.insert(left->children.end(), right->children.begin(),
+                                  right->children.begin() + count);
+            right->children.erase(right->children.begin(), right->children.begin() + count);
+        }
+        index_keys(left);
+        index_keys(right);
+        index_keys(parent);
+        note_borrow();
+    }
+
+    // Split children[index] and children[index + 1], each full or one
+    // slot short, into three nodes about 2/3 full. The new middle node
+    // takes the tail of the left node, the separator and the head of the
+    // right node. Needs at least three keys to share out.
+    void split_two_three(Node* parent, size_t index) {
+        Node* left = parent->children[index];
+        Node* right = parent->children[index + 1];
+        Node* middle = new Node(left->is_leaf);
+
+        // Sizes differ by at most one; the middle node, then the fuller
+        // side, take the remainder, so no key moves away from its side
+        // more than needed
+        size_t total = left->keys.size() + right->keys.size() - 1;  // Two keys go up as separators
+        size_t left_keys = total / 3;
+        size_t middle_keys = total / 3 + (total % 3 > 0 ? 1 : 0);
+        if (total % 3 == 2 && left->keys.size() >= right->keys.size()) {
+            left_keys++;
+        }
+        size_t from_right = left_keys + middle_keys - left->keys.size();  // Right keys moved to middle
+
+        middle->keys.assign(std::make_move_iterator(left->keys.begin() + left_keys + 1),
+                            std::make_move_iterator(left->keys.end()));
+        middle->keys.push_back(std::move(parent->keys[index]));
+        middle->keys.insert(middle->keys.end(), std::make_move_iterator(right->keys.begin()),
+                            std::make_move_iterator(right->keys.begin() + from_right));
+        parent->keys[index] = std::move(left->keys[left_keys]);
+        T upper = std::move(right->keys[from_right]);
+        left->keys.resize(left_keys);
+        right->keys.erase(right->keys.begin(), right->keys.begin() + from_right + 1);
+
+        if (!left->is_leaf) {
+            middle->children.assign(left->children.begin() + left_keys + 1, left->children.end());
+            middle->children.insert(middle->children.end(), right->children.begin(),
+                                    right->children.begin() + from_right + 1);
+            left->children.resize(left_keys + 1);
+            right->children.erase(right->children.begin(), right->children.begin() + from_right + 1);
+        }
+
+        parent->keys.insert(parent->keys.begin() + index + 1, std::move(upper));
+        parent->children.insert(parent->children.begin() + index + 1, middle);
+        index_keys(left);
+        index_keys(middle);
+        index_keys(right);
+        index_keys(parent);
+        note_split();
+    }
+
+    // Make room in full children[i] under SplitPolicy::Redistribute. Both
+    // nodes must end up non-full, since the key may descend into either:
+    // keys move into an adjacent sibling with two or more free slots, or
+    // the child is split together with a sibling into three nodes (an
+    // even split when Order 3 leaves too few keys for three). Moves i to
+    // the first affected child and returns how many separators now bound
+    // the affected children.
+    size_t redistribute_child(Node* parent, size_t& i) {
+        const size_t full = static_cast<size_t>(max_keys);
+        if (i + 1 < parent->children.size()) {
+            touch(parent->children[i + 1], cost_);
+            size_t room = full - parent->children[i + 1]->keys.size();
+            if (room > 1) {
+                shift_right(parent, i, room / 2);
+                return 1;
+            }
+        }
+        if (i > 0) {
+            touch(parent->children[i - 1], cost_);
+            size_t room = full - parent->children[i - 1]->keys.size();
+            if (room > 1) {
+                i--;
+                shift_left(parent, i, room / 2);
+                return 1;
+            }
+        }
+        size_t first = i + 1 < parent->children.size() ? i : i - 1;
+        if (parent->children[first]->keys.size() + parent->children[first + 1]->keys.size() < 4) {
+            split_child(parent, i);
+            return 1;
+        }
+        i = first;
+        split_two_three(parent, first);
+        return 2;
     }
 
     void insert_non_full(Node* node, const T& key) {
+        touch(node, cost_);
         if (node->is_leaf) {
             // Use binary search to find insertion position
-            auto pos = std::lower_bound(node->keys.begin(), node->keys.end(), key);
-            node->keys.insert(pos, key);
+            size_t i = lower_index(node, key, cost_);
+            node->keys.insert(node->keys.begin() + i, key);
+            index_keys(node, i);
         } else {
             // Use binary search to find child
-            auto pos = std::upper_bound(node->keys.begin(), node->keys.end(), key);
-            size_t i = pos - node->keys.begin();
+            size_t i = upper_index(node, key, cost_);
 
             if (node->children[i]->keys.size() == static_cast<size_t>(max_keys)) {
-                split_child(node, i);
-                if (key > node->keys[i]) {
-                    i++;
+                size_t separators = 1;
+                if (split_policy_ == SplitPolicy::Redistribute && node->children.size() > 1) {
+                    separators = redistribute_child(node, i);
+                } else {
+                    split_child(node, i);
+                }
+                // Re-route key among the children whose boundaries moved
+                for (size_t last = i + separators; i < last; i++) {
+                    if (cost_ != nullptr) {
+                        cost_->comparisons++;
+                    }
+                    if (!(key > node->keys[i])) {
+                        break;
+                    }
                 }
             }
             insert_non_full(node->children[i], key);
         }
     }
 
-    Node* search_node(Node* node, const T& key) const {
+    // InsertStrategy::BottomUp: descend to the leaf remembering the deepest
+    // node with room. A leaf with room takes the key directly; a full leaf
+    // sends the key back down from that node, splitting the full nodes
+    // below it (a new root first if every node on the path is full).
+    void insert_bottom_up(const T& key) {
+        Node* anchor = nullptr;
+        Node* node = root;
+        while (true) {
+            touch(node, cost_);
+            if (node->keys.size() < static_cast<size_t>(max_keys)) {
+                anchor = node;
+            }
+            if (node->is_leaf) {
+                break;
+            }
+            node = node->children[upper_index(node, key, cost_)];
+        }
+
+        if (node == anchor) {
+            size_t i = lower_index(node, key, cost_);
+            node->keys.insert(node->keys.begin() + i, key);
+            index_keys(node, i);
+            return;
+        }
+        if (anchor == nullptr) {
+            grow_root();
+            anchor = root;
+        }
+        insert_non_full(anchor, key);
+    }
+
+    // Split a full root under a new root, making the tree one level taller
+    void grow_root() {
+        Node* new_root = new Node(false);
+        new_root->children.push_back(root);
+        split_child(new_root, 0);
+        root = new_root;
+    }
+
+    Node* search_node(Node* node, const T& key, OpCost* cost = nullptr) const {
+        touch(node, cost);
         // Binary search for key position
-        auto it = std::lower_bound(node->keys.begin(), node->keys.end(), key);
-        size_t i = it - node->keys.begin();
+        size_t i = lower_index(node, key, cost);
 
-        if (i < node->keys.size() && node->keys[i] == key) {
+        if (key_at(node, i, key, cost)) {
             return node;
         }
 
@@ -193,7 +991,7 @@ private:
             return nullptr;
         }
 
-        return search_node(node->children[i], key);
+        return search_node(node->children[i], key, cost);
     }
 
     void traverse_node(Node* node) const {
@@ -234,6 +1032,76 @@ private:
         return 1 + calculate_height(node->children[0]);
     }
 
+    void collect_stats(Node* node, Stats& stats) const noexcept {
+        stats.nodes++;
+        stats.keys += node->keys.size();
+        stats.memory_bytes += node_bytes(node);
+        if (node->is_leaf) {
+            stats.leaf_nodes++;
+            return;
+        }
+        stats.internal_nodes++;
+        for (Node* child : node->children) {
+            collect_stats(child, stats);
+        }
+    }
+
+    static void reset_visits(Node* node) noexcept {
+        node->visits.store(0, std::memory_order_relaxed);
+        for (Node* child : node->children) {
+            reset_visits(child);
+        }
+    }
+
+    static size_t node_bytes(const Node* node) noexcept {
+        return sizeof(Node) + node->keys.capacity() * sizeof(T) + node->children.capacity() * sizeof(Node*);
+    }
+
+    void collect_heat(const Node* node, size_t depth, Heatmap& heat) const {
+        if (heat.levels.size() <= depth) {
+            heat.levels.resize(depth + 1);
+        }
+        auto& level = heat.levels[depth];
+        level.nodes++;
+        uint32_t visits = node->visits.load(std::memory_order_relaxed);
+        level.visits += visits;
+        heat.visits += visits;
+        size_t bytes = node_bytes(node);
+        heat.memory_bytes += bytes;
+        if (visits == 0) {
+            level.cold_nodes++;
+            heat.cold_bytes += bytes;
+        }
+        for (const Node* child : node->children) {
+            collect_heat(child, depth + 1, heat);
+        }
+    }
+
+    // Visits and node count of the subtree rooted at node
+    static void subtree_heat(const Node* node, typename Heatmap::Subtree& subtree) noexcept {
+        subtree.nodes++;
+        subtree.visits += node->visits.load(std::memory_order_relaxed);
+        for (const Node* child : node->children) {
+            subtree_heat(child, subtree);
+        }
+    }
+
+    static void collect_subtrees(Node* node, size_t depth, size_t target,
+                                 std::vector<typename Heatmap::Subtree>& out) {
+        if (depth == target) {
+            typename Heatmap::Subtree subtree;
+            subtree.depth = depth;
+            subtree.first = get_successor(node);
+            subtree.last = get_predecessor(node);
+            subtree_heat(node, subtree);
+            out.push_back(subtree);
+            return;
+        }
+        for (Node* child : node->children) {
+            collect_subtrees(child, depth + 1, target, out);
+        }
+    }
+
     template<typename Func>
     void for_each_node(Node* node, Func& f) const {
         size_t i;
@@ -249,14 +1117,14 @@ private:
         }
     }
 
-    const T& get_predecessor(Node* node) const {
+    static const T& get_predecessor(Node* node) {
         while (!node->is_leaf) {
             node = node->children.back();
         }
         return node->keys.back();
     }
 
-    const T& get_successor(Node* node) const {
+    static const T& get_successor(Node* node) {
         while (!node->is_leaf) {
             node = node->children[0];
         }
@@ -280,10 +1148,13 @@ private:
         // Remove key from parent
         node->keys.erase(node->keys.begin() + idx);
         node->children.erase(node->children.begin() + idx + 1);
+        index_keys(left);
+        index_keys(node);
 
         // Delete right node (but not its children, as they're now in left)
         right->children.clear();
         delete right;
+        note_merge();
 
         // For small orders (like 3), merging can cause overflow.
         // If so, split the merged node and push a key back to parent.
@@ -310,6 +1181,10 @@ private:
             // Insert middle key back into parent at the same position
             node->keys.insert(node->keys.begin() + idx, mid_key);
             node->children.insert(node->children.begin() + idx + 1, new_node);
+            index_keys(left);
+            index_keys(new_node);
+            index_keys(node);
+            note_split();
         }
     }
 
@@ -334,6 +1209,7 @@ private:
     }
 
     void borrow_from_prev(Node* node, size_t idx) {
+        note_borrow();
         Node* child = node->children[idx];
         Node* sibling = node->children[idx - 1];
 
@@ -349,9 +1225,13 @@ private:
             child->children.insert(child->children.begin(), sibling->children.back());
             sibling->children.pop_back();
         }
+        index_keys(child);
+        index_keys(sibling);
+        index_keys(node);
     }
 
     void borrow_from_next(Node* node, size_t idx) {
+        note_borrow();
         Node* child = node->children[idx];
         Node* sibling = node->children[idx + 1];
 
@@ -367,56 +1247,108 @@ private:
             child->children.push_back(sibling->children[0]);
             sibling->children.erase(sibling->children.begin());
         }
+        index_keys(child);
+        index_keys(sibling);
+        index_keys(node);
+    }
+
+    // Remove and return the largest key of the subtree in one descent down
+    // its right edge, topping up each child before entering it. node must
+    // hold more than min_keys keys (except in the odd-order merge case).
+    T remove_max(Node* node) {
+        while (!node->is_leaf) {
+            touch(node, cost_);
+            size_t last = node->children.size() - 1;
+            if (node->children[last]->keys.size() <= static_cast<size_t>(min_keys)) {
+                fill_child(node, last);
+            }
+            node = node->children.back();
+        }
+        touch(node, cost_);
+        T key = std::move(node->keys.back());
+        node->keys.pop_back();
+        index_keys(node, node->keys.size());
+        return key;
+    }
+
+    // Mirror of remove_max() down the left edge
+    T remove_min(Node* node) {
+        while (!node->is_leaf) {
+            touch(node, cost_);
+            if (node->children[0]->keys.size() <= static_cast<size_t>(min_keys)) {
+                fill_child(node, 0);
+            }
+            node = node->children[0];
+        }
+        touch(node, cost_);
+        T key = std::move(node->keys.front());
+        node->keys.erase(node->keys.begin());
+        index_keys(node);
+        return key;
+    }
+
+    // Remove keys[idx] of a node already visited by the caller. Internal keys
+    // are replaced by the predecessor or successor, which is unlinked in the
+    // same descent that finds it; after a merge the key's new position is
+    // known, so nothing is searched twice.
+    bool remove_at(Node* node, size_t idx) {
+        if (node->is_leaf) {
+            // Case 1: Key is in leaf node - simply remove it
+            node->keys.erase(node->keys.begin() + idx);
+            index_keys(node, idx);
+            return true;
+        }
+
+        // Case 2: Key is in internal node
+        // For Order 3, merging two min-key children causes overflow (3 keys > max 2).
+        // Always use predecessor/successor approach to avoid this issue.
+        if (node->children[idx]->keys.size() > static_cast<size_t>(min_keys)) {
+            // Case 2a: Left child has enough keys
+            node->keys[idx] = remove_max(node->children[idx]);
+            index_keys(node, idx);
+            return true;
+        }
+        if (node->children[idx + 1]->keys.size() > static_cast<size_t>(min_keys)) {
+            // Case 2b: Right child has enough keys
+            node->keys[idx] = remove_min(node->children[idx + 1]);
+            index_keys(node, idx);
+            return true;
+        }
+
+        // Case 2c: Both children have minimum keys - merge them. The key at
+        // node->keys[idx] moves down to position `left` of the merged child.
+        size_t left = node->children[idx]->keys.size();
+        size_t children = node->children.size();
+        merge_children(node, idx);
+        touch(node->children[idx], cost_);
+        if (node->children.size() < children) {
+            return remove_at(node->children[idx], left);
+        }
+
+        // Odd orders: the merged node overflowed and was split again around
+        // its middle key, leaving `mid` keys on the left
+        size_t mid = node->children[idx]->keys.size();
+        if (left < mid) {
+            return remove_at(node->children[idx], left);
+        }
+        if (left == mid) {
+            // Key was pushed back up as the split middle - use the predecessor
+            node->keys[idx] = remove_max(node->children[idx]);
+            index_keys(node, idx);
+            return true;
+        }
+        touch(node->children[idx + 1], cost_);
+        return remove_at(node->children[idx + 1], left - mid - 1);
     }
 
     bool remove_from_node(Node* node, const T& key) {
+        touch(node, cost_);
         // Binary search for key position
-        auto it = std::lower_bound(node->keys.begin(), node->keys.end(), key);
-        size_t idx = it - node->keys.begin();
+        size_t idx = lower_index(node, key, cost_);
 
         // Key found in this node
-        if (idx < node->keys.size() && node->keys[idx] == key) {
-            if (node->is_leaf) {
-                // Case 1: Key is in leaf node - simply remove it
-                node->keys.erase(node->keys.begin() + idx);
-                return true;
-            } else {
-                // Case 2: Key is in internal node
-                // For Order 3, merging two min-key children causes overflow (3 keys > max 2).
-                // Always use predecessor/successor approach to avoid this issue.
-                if (node->children[idx]->keys.size() > static_cast<size_t>(min_keys)) {
-                    // Case 2a: Left child has enough keys
-                    T pred = get_predecessor(node->children[idx]);
-                    node->keys[idx] = pred;
-                    return remove_from_node(node->children[idx], pred);
-                } else if (node->children[idx + 1]->keys.size() > static_cast<size_t>(min_keys)) {
-                    // Case 2b: Right child has enough keys
-                    T succ = get_successor(node->children[idx + 1]);
-                    node->keys[idx] = succ;
-                    return remove_from_node(node->children[idx + 1], succ);
-                } else {
-                    // Case 2c: Both children have minimum keys - merge them
-                    // The key at node->keys[idx] gets pushed down to merged child.
-                    // merge_children handles overflow by splitting if needed.
-                    merge_children(node, idx);
-
-                    // After merge (and possible split), find where the key ended up.
-                    // Search for it in the current node first.
-                    auto new_it = std::lower_bound(node->keys.begin(), node->keys.end(), key);
-                    size_t new_idx = new_it - node->keys.begin();
-
-                    if (new_idx < node->keys.size() && node->keys[new_idx] == key) {
-                        // Key was pushed back up as the split middle - handle as internal node key
-                        // Use Case 2a (predecessor) since left child should have enough keys after split
-                        T pred = get_predecessor(node->children[new_idx]);
-                        node->keys[new_idx] = pred;
-                        return remove_from_node(node->children[new_idx], pred);
-                    } else {
-                        // Key is in one of the children
-                        return remove_from_node(node->children[new_idx], key);
-                    }
-                }
-            }
+        if (key_at(node, idx, key, cost_)) {
+            return remove_at(node, idx);
         } else {
             // Key not in this node
             if (node->is_leaf) {
@@ -439,8 +1371,183 @@ private:
         }
     }
 
+    // Iterator at the first key not less than (Upper: greater than) key.
+    // Every level pushes the index of the next separator to visit, so when
+    // the leaf is exhausted advance() resumes at the right ancestor key.
+    template <bool Upper>
+    iterator bound_impl(const T& key) const {
+        iterator result(nullptr);
+        Node* node = root;
+        while (node != nullptr) {
+            touch(node);
+            size_t i = Upper ? upper_index(node, key) : lower_index(node, key);
+            result.stack_.push({node, i});
+            if (node->is_leaf) {
+                break;
+            }
+            node = node->children[i];
+        }
+        result.advance();
+        return result;
+    }
+
+    // Visit keys >= from in order until remaining reaches zero. emit(first,
+    // count) receives runs of consecutive keys: whole leaf ranges, or single
+    // separator keys of internal nodes. Returns false once the limit is hit.
+    template <typename Emit>
+    bool scan_node(Node* node, const T* from, size_t& remaining, Emit& emit) const {
+        touch(node);
+        size_t i = from != nullptr ? lower_index(node, *from) : 0;
+        if (node->is_leaf) {
+            size_t count = std::min(node->keys.size() - i, remaining);
+            if (count > 0) {
+                emit(node->keys.data() + i, count);
+                remaining -= count;
+            }
+            return remaining > 0;
+        }
+        if (!scan_node(node->children[i], from, remaining, emit)) {
+            return false;
+        }
+        for (; i < node->keys.size(); i++) {
+            emit(node->keys.data() + i, 1);
+            if (--remaining == 0 || !scan_node(node->children[i + 1], nullptr, remaining, emit)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Keys held by a full subtree of the given height (saturating)
+    static size_t subtree_capacity(size_t height) noexcept {
+        size_t capacity = 1;
+        for (size_t h = 0; h < height; h++) {
+            if (capacity > SIZE_MAX / Order) {
+                return SIZE_MAX;
+            }
+            capacity *= Order;
+        }
+        return capacity - 1;
+    }
+
+    // Build a subtree of exactly `height` levels from count sorted keys.
+    // Children get near-equal shares of the keys with one separator between
+    // neighbours. Using the fewest children that fit packs nodes nearly
+    // full; non-root nodes take at least min_keys + 1 children, which the
+    // caller's share guarantees can each still reach min_keys per node.
+    template <typename RandomIt>
+    static Node* build_sorted(RandomIt first, size_t count, size_t height, bool is_root) {
+        if (height == 1) {
+            Node* leaf = new Node(true);
+            leaf->keys.assign(first, first + count);
+            index_keys(leaf);
+            return leaf;
+        }
+
+        size_t child_capacity = subtree_capacity(height - 1);
+        size_t children = count / (child_capacity + 1) + 1;  // ceil((count + 1) / (capacity + 1))
+        if (!is_root) {
+            children = std::max(children, static_cast<size_t>(min_keys + 1));
+        }
+
+        Node* node = new Node(false);
+        size_t child_keys = count - (children - 1);
+        size_t base = child_keys / children;
+        size_t extra = child_keys % children;
+        for (size_t c = 0; c < children; c++) {
+            size_t share = base + (c < extra ? 1 : 0);
+            node->children.push_back(build_sorted(first, share, height - 1, false));
+            first += share;
+            if (c + 1 < children) {
+                node->keys.push_back(*first);
+                ++first;
+            }
+        }
+        index_keys(node);
+        return node;
+    }
+
+    // Nodes at the given depth in key order, plus the ancestor keys that
+    // separate consecutive ones. Nodes above that depth are added to top.
+    static void collect_frontier(Node* node, size_t depth, std::vector<Node*>& frontier,
+                                 std::vector<T>& separators, std::vector<Node*>& top) {
+        if (depth == 0) {
+            frontier.push_back(node);
+            return;
+        }
+        top.push_back(node);
+        for (size_t i = 0; i < node->children.size(); i++) {
+            if (i > 0) {
+                separators.push_back(node->keys[i - 1]);
+            }
+            collect_frontier(node->children[i], depth - 1, frontier, separators, top);
+        }
+    }
+
+    // Build internal levels over equal-height subtrees (one separator between
+    // neighbours) and return the new root. Each level uses the fewest nodes
+    // that fit, sharing children evenly, so every non-root node keeps at
+    // least min_keys + 1 children.
+    static Node* build_levels(std::vector<Node*> nodes, std::vector<T> separators) {
+        while (nodes.size() > 1) {
+            size_t groups = (nodes.size() + Order - 1) / Order;
+            size_t base = nodes.size() / groups;
+            size_t extra = nodes.size() % groups;
+            std::vector<Node*> parents;
+            std::vector<T> parent_separators;
+            size_t next = 0;
+            for (size_t g = 0; g < groups; g++) {
+                size_t share = base + (g < extra ? 1 : 0);
+                Node* parent = new Node(false);
+                for (size_t c = 0; c < share; c++, next++) {
+                    if (c > 0) {
+                        parent->keys.push_back(std::move(separators[next - 1]));
+                    }
+                    parent->children.push_back(nodes[next]);
+                }
+                if (next < nodes.size()) {
+                    parent_separators.push_back(std::move(separators[next - 1]));
+                }
+                index_keys(parent);
+                parents.push_back(parent);
+            }
+            nodes = std::move(parents);
+            separators = std::move(parent_separators);
+        }
+        return nodes.front();
+    }
+
+    // Layout of serialize(): 32-byte header followed by the keys in order
+    static constexpr char serialized_magic[8] = {'B', 'T', 'R', 'E', 'E', 'v', '1', '\0'};
+    static constexpr size_t serialized_header_size = 32;
+
+    // Returns the key count after validating a serialized header
+    static uint64_t parse_serialized_header(const char* header) {
+        uint32_t key_size = 0;
+        uint64_t count = 0;
+        std::memcpy(&key_size, header + 8, sizeof(key_size));
+        std::memcpy(&count, header + 16, sizeof(count));
+        if (std::memcmp(header, serialized_magic, sizeof(serialized_magic)) != 0) {
+            throw std::runtime_error("not a serialized BTree");
+        }
+        if (key_size != sizeof(T)) {
+            throw std::runtime_error("serialized BTree key size mismatch");
+        }
+        return count;
+    }
+
+    // from_sorted() for deserialized keys, reporting unsorted input as
+    // malformed
+    template <typename RandomIt>
+    static BTree from_serialized_keys(RandomIt first, RandomIt last) {
+        if (!std::is_sorted(first, last)) {
+            throw std::runtime_error("serialized BTree keys out of order");
+        }
+        return from_sorted(first, last);
+    }
+
     // Helper to find a key and build iterator stack
-    iterator find_impl(const T& key) const {
+    iterator find_impl(const T& key, OpCost* cost = nullptr) const {
         if (root == nullptr) {
             return iterator();
         }
@@ -452,10 +1559,10 @@ private:
         Node* node = root;
 
         while (node != nullptr) {
-            auto it = std::lower_bound(node->keys.begin(), node->keys.end(), key);
-            size_t i = it - node->keys.begin();
+            touch(node, cost);
+            size_t i = lower_index(node, key, cost);
 
-            if (i < node->keys.size() && node->keys[i] == key) {
+            if (key_at(node, i, key, cost)) {
                 // Found the key - build iterator at this position
                 // Push current node with index pointing to the found key
                 path.push({node, i});
@@ -505,7 +1612,9 @@ public:
     BTree& operator=(const BTree&) = delete;
 
     // Move constructor
-    BTree(BTree&& other) noexcept : root(other.root), size_(other.size_) {
+    BTree(BTree&& other) noexcept
+        : root(other.root), size_(other.size_), profiling_(other.profiling_),
+          split_policy_(other.split_policy_), insert_strategy_(other.insert_strategy_), metrics_(other.metrics_) {
         other.root = nullptr;
         other.size_ = 0;
     }
@@ -516,34 +1625,395 @@ public:
             delete root;
             root = other.root;
             size_ = other.size_;
+            profiling_ = other.profiling_;
+            split_policy_ = other.split_policy_;
+            insert_strategy_ = other.insert_strategy_;
+            metrics_ = other.metrics_;
             other.root = nullptr;
             other.size_ = 0;
         }
         return *this;
     }
 
+    // O(n) - Build a tree from keys in non-decreasing order without any
+    // splitting. Nodes are packed nearly full, so it is the fastest way to
+    // load a large tree. Throws std::invalid_argument if keys are unsorted.
+    template <typename RandomIt>
+    [[nodiscard]] static BTree from_sorted(RandomIt first, RandomIt last) {
+        static_assert(std::is_base_of_v<std::random_access_iterator_tag,
+                          typename std::iterator_traits<RandomIt>::iterator_category>,
+                      "from_sorted requires random access iterators");
+        BTree tree;
+        size_t count = static_cast<size_t>(last - first);
+        if (count == 0) {
+            return tree;
+        }
+        for (RandomIt it = first + 1; it != last; ++it) {
+            if (*it < *(it - 1)) {
+                throw std::invalid_argument("from_sorted requires sorted keys");
+            }
+        }
+
+        size_t height = 1;
+        while (subtree_capacity(height) < count) {
+            height++;
+        }
+        tree.root = build_sorted(first, count, height, true);
+        tree.size_ = count;
+        return tree;
+    }
+
+    [[nodiscard]] static BTree from_sorted(const std::vector<T>& keys) {
+        return from_sorted(keys.begin(), keys.end());
+    }
+
+    // O(n) - Write all keys in binary form: a 32-byte header (magic, key
+    // size, order, count) followed by the raw keys in sorted order. Requires
+    // a trivially copyable key type; the format uses native byte order.
+    void serialize(std::ostream& os) const {
+        static_assert(std::is_trivially_copyable_v<T>, "serialize requires trivially copyable keys");
+        char header[serialized_header_size] = {};
+        uint32_t key_size = sizeof(T);
+        uint32_t order = Order;
+        uint64_t count = size_;
+        std::memcpy(header, serialized_magic, sizeof(serialized_magic));
+        std::memcpy(header + 8, &key_size, sizeof(key_size));
+        std::memcpy(header + 12, &order, sizeof(order));
+        std::memcpy(header + 16, &count, sizeof(count));
+        os.write(header, sizeof(header));
+
+        // Buffer keys so the stream sees large writes
+        std::vector<T> buffer;
+        buffer.reserve(std::max<size_t>(1, 65536 / sizeof(T)));
+        auto flush = [&os, &buffer] {
+            os.write(reinterpret_cast<const char*>(buffer.data()),
+                     static_cast<std::streamsize>(buffer.size() * sizeof(T)));
+            buffer.clear();
+        };
+        for_each([&](const T& key) {
+            buffer.push_back(key);
+            if (buffer.size() == buffer.capacity()) {
+                flush();
+            }
+        });
+        flush();
+        if (!os) {
+            throw std::runtime_error("failed to write serialized BTree");
+        }
+    }
+
+    // O(n) - Write all keys in sorted order as text, one per line. Numbers
+    // use std::to_chars, strings are written as they are (a key containing
+    // a line break throws std::invalid_argument) and other types use
+    // operator<<. Output is assembled in 1 MiB blocks, so the stream sees
+    // large writes and is never flushed per key.
+    void dump_text(std::ostream& os) const {
+        constexpr size_t block = 1 << 20;
+        std::string buffer;
+        buffer.reserve(block + 256);
+        for_each([&](const T& key) {
+            btree_detail::TextKey<T>::append(buffer, key);
+            buffer += '\n';
+            if (buffer.size() >= block) {
+                os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        });
+        os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        if (!os) {
+            throw std::runtime_error("failed to write BTree text");
+        }
+    }
+
+    // O(n) for sorted input, O(n log n) otherwise - Read keys written one
+    // per line (e.g. by dump_text()), parsed with std::from_chars for
+    // numbers, and bulk-build the tree. A trailing \r is accepted on
+    // number lines. Throws std::runtime_error naming the first malformed
+    // line.
+    [[nodiscard]] static BTree load_text(std::istream& is) {
+        std::vector<T> keys;
+        std::vector<char> buffer(1 << 20);
+        size_t filled = 0;
+        size_t line_number = 0;
+        auto parse = [&](const char* first, const char* last) {
+            line_number++;
+            if (std::is_arithmetic_v<T> && last != first && last[-1] == '\r') {
+                last--;
+            }
+            T key{};
+            if (!btree_detail::TextKey<T>::parse(std::string_view(first, static_cast<size_t>(last - first)), key)) {
+                throw std::runtime_error("malformed BTree text at line " + std::to_string(line_number));
+            }
+            keys.push_back(std::move(key));
+        };
+
+        while (true) {
+            is.read(buffer.data() + filled, static_cast<std::streamsize>(buffer.size() - filled));
+            filled += static_cast<size_t>(is.gcount());
+            bool done = !is;
+            const char* line = buffer.data();
+            const char* end = buffer.data() + filled;
+            while (line != end) {
+                const void* newline = std::memchr(line, '\n', static_cast<size_t>(end - line));
+                if (newline == nullptr) {
+                    break;
+                }
+                parse(line, static_cast<const char*>(newline));
+                line = static_cast<const char*>(newline) + 1;
+            }
+            filled = static_cast<size_t>(end - line);
+            if (done) {
+                if (filled > 0) {
+                    parse(line, end);  // Last line without a line break
+                }
+                break;
+            }
+            std::memmove(buffer.data(), line, filled);
+            if (filled == buffer.size()) {
+                buffer.resize(buffer.size() * 2);  // One line fills the buffer
+            }
+        }
+        if (is.bad()) {
+            throw std::runtime_error("failed to read BTree text");
+        }
+
+        if (!std::is_sorted(keys.begin(), keys.end())) {
+            std::sort(keys.begin(), keys.end());
+        }
+        return from_sorted(keys.begin(), keys.end());
+    }
+
+    // O(n) - Read a tree written by serialize() (any order) and bulk-build it.
+    // Throws std::runtime_error on malformed or truncated input.
+    [[nodiscard]] static BTree deserialize(std::istream& is) {
+        static_assert(std::is_trivially_copyable_v<T>, "deserialize requires trivially copyable keys");
+        char header[serialized_header_size];
+        if (!is.read(header, sizeof(header))) {
+            throw std::runtime_error("truncated serialized BTree header");
+        }
+        uint64_t count = parse_serialized_header(header);
+
+        // Read in bounded chunks so a corrupt count fails as truncated input
+        // instead of allocating (or overflowing) count * sizeof(T) up front
+        constexpr size_t chunk = std::max<size_t>(1, (size_t(1) << 20) / sizeof(T));
+        std::vector<T> keys;
+        keys.reserve(static_cast<size_t>(std::min<uint64_t>(count, chunk)));
+        for (uint64_t remaining = count; remaining > 0;) {
+            size_t take = static_cast<size_t>(std::min<uint64_t>(remaining, chunk));
+            size_t filled = keys.size();
+            keys.resize(filled + take);
+            if (!is.read(reinterpret_cast<char*>(keys.data() + filled), static_cast<std::streamsize>(take * sizeof(T)))) {
+                throw std::runtime_error("truncated serialized BTree keys");
+            }
+            remaining -= take;
+        }
+        return from_serialized_keys(keys.begin(), keys.end());
+    }
+
+    // O(n) - Build from a serialize() image already in memory (for example a
+    // memory-mapped file), reading keys in place when suitably aligned.
+    // Throws std::runtime_error on malformed or truncated input.
+    [[nodiscard]] static BTree from_serialized(const void* data, size_t bytes) {
+        static_assert(std::is_trivially_copyable_v<T>, "from_serialized requires trivially copyable keys");
+        const char* bytes_ptr = static_cast<const char*>(data);
+        if (bytes < serialized_header_size) {
+            throw std::runtime_error("truncated serialized BTree header");
+        }
+        uint64_t count = parse_serialized_header(bytes_ptr);
+        if ((bytes - serialized_header_size) / sizeof(T) < count) {
+            throw std::runtime_error("truncated serialized BTree keys");
+        }
+
+        const char* key_bytes = bytes_ptr + serialized_header_size;
+        if (reinterpret_cast<uintptr_t>(key_bytes) % alignof(T) == 0) {
+            const T* keys = reinterpret_cast<const T*>(key_bytes);
+            return from_serialized_keys(keys, keys + count);
+        }
+        std::vector<T> keys(static_cast<size_t>(count));
+        std::memcpy(keys.data(), key_bytes, static_cast<size_t>(count) * sizeof(T));
+        return from_serialized_keys(keys.begin(), keys.end());
+    }
+
     // O(log n) - Insert a key into the tree
     void insert(const T& key) {
+        BTreeMetrics::Scope metered(metrics_, BTreeMetrics::Insert);
         if (root == nullptr) {
             root = new Node(true);
             root->keys.push_back(key);
+            index_keys(root);
             size_++;
             return;
         }
 
-        if (root->keys.size() == static_cast<size_t>(max_keys)) {
-            Node* new_root = new Node(false);
-            new_root->children.push_back(root);
-            split_child(new_root, 0);
-            root = new_root;
+        if (insert_strategy_ == InsertStrategy::BottomUp) {
+            insert_bottom_up(key);
+        } else {
+            if (root->keys.size() == static_cast<size_t>(max_keys)) {
+                grow_root();
+            }
+            insert_non_full(root, key);
         }
-
-        insert_non_full(root, key);
         size_++;
     }
 
+    // O(k log n / threads) - Insert a batch of keys using several threads.
+    // The batch is sorted, the tree is cut at the shallowest level with
+    // enough nodes to share out, and each worker inserts its key range into
+    // its own disjoint subtrees without locking. A subtree whose root
+    // splits simply grows wider at that level; the levels above the cut are
+    // then rebuilt over the new subtrees. threads == 0 uses all hardware
+    // threads. Invalidates all iterators; not safe against concurrent use.
+    void parallel_insert_batch(std::vector<T> keys, size_t threads = 0) {
+        if (keys.empty()) {
+            return;
+        }
+        std::sort(keys.begin(), keys.end());
+        if (root == nullptr) {
+            // Take only the nodes, keeping this tree's settings
+            BTree built = from_sorted(keys.begin(), keys.end());
+            std::swap(root, built.root);
+            std::swap(size_, built.size_);
+            return;
+        }
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        // Cut at the first level wide enough to balance work across threads
+        size_t target_width = threads * 8;
+        size_t depth = 0;
+        std::vector<Node*> level = {root};
+        while (!level.front()->is_leaf && level.size() < target_width) {
+            std::vector<Node*> next;
+            for (Node* node : level) {
+                next.insert(next.end(), node->children.begin(), node->children.end());
+            }
+            level = std::move(next);
+            depth++;
+        }
+        if (depth == 0) {
+            for (const T& key : keys) {
+                insert(key);
+            }
+            return;
+        }
+
+        std::vector<Node*> frontier;
+        std::vector<T> separators;
+        std::vector<Node*> top;
+        collect_frontier(root, depth, frontier, separators, top);
+
+        // Key range routed to each frontier subtree (equal keys go right,
+        // matching insert())
+        std::vector<size_t> bounds(frontier.size() + 1, keys.size());
+        bounds[0] = 0;
+        for (size_t j = 0; j < separators.size(); j++) {
+            bounds[j + 1] = static_cast<size_t>(
+                std::upper_bound(keys.begin() + bounds[j], keys.end(), separators[j]) - keys.begin());
+        }
+
+        // Each subtree is grown under a wrapper node that is never split.
+        // Wrappers only borrow their children; the guard detaches them
+        // before the wrappers are destroyed, even if a later step throws.
+        std::deque<Node> wrappers;
+        struct Detach {
+            std::deque<Node>& wrappers;
+            ~Detach() {
+                for (Node& wrapper : wrappers) {
+                    wrapper.children.clear();
+                }
+            }
+        } detach{wrappers};
+        for (Node* subtree : frontier) {
+            wrappers.emplace_back(false);
+            wrappers.back().children.push_back(subtree);
+        }
+        std::vector<size_t> inserted(frontier.size(), 0);
+        std::vector<std::exception_ptr> errors(threads);
+        auto work = [&](size_t first, size_t last, size_t worker) {
+            try {
+                for (size_t j = first; j < last; j++) {
+                    for (size_t k = bounds[j]; k < bounds[j + 1]; k++) {
+                        insert_non_full(&wrappers[j], keys[k]);
+                        inserted[j]++;
+                    }
+                }
+            } catch (...) {
+                errors[worker] = std::current_exception();
+            }
+        };
+
+        // Contiguous frontier ranges with roughly equal key counts
+        std::vector<std::thread> workers;
+        size_t first = 0;
+        for (size_t t = 0; t < threads && first < frontier.size(); t++) {
+            size_t last = frontier.size();
+            if (t + 1 < threads) {
+                size_t goal = keys.size() * (t + 1) / threads;
+                last = first + 1;
+                while (last < frontier.size() && bounds[last] < goal) {
+                    last++;
+                }
+            }
+            if (last == frontier.size()) {
+                work(first, last, t);  // The final range runs on this thread
+            } else {
+                try {
+                    workers.emplace_back(work, first, last, t);
+                } catch (...) {
+                    work(first, last, t);  // No thread available: run it here
+                }
+            }
+            first = last;
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        // Rebuild the levels above the cut over the grown subtrees
+        std::vector<Node*> subtrees;
+        std::vector<T> subtree_separators;
+        for (size_t j = 0; j < frontier.size(); j++) {
+            if (j > 0) {
+                subtree_separators.push_back(std::move(separators[j - 1]));
+            }
+            Node& wrapper = wrappers[j];
+            for (size_t c = 0; c < wrapper.children.size(); c++) {
+                if (c > 0) {
+                    subtree_separators.push_back(std::move(wrapper.keys[c - 1]));
+                }
+                subtrees.push_back(wrapper.children[c]);
+            }
+            size_ += inserted[j];
+        }
+        for (Node* node : top) {
+            node->children.clear();
+            delete node;
+        }
+        root = build_levels(std::move(subtrees), std::move(subtree_separators));
+
+        for (const std::exception_ptr& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    // O(log n) - insert() that adds the work it does to cost
+    void insert(const T& key, OpCost& cost) {
+        CostScope scope(*this, cost);
+        insert(key);
+    }
+
+    // O(log n) - remove() that adds the work it does to cost
+    bool remove(const T& key, OpCost& cost) {
+        CostScope scope(*this, cost);
+        return remove(key);
+    }
+
     // O(log n) - Remove a key from the tree. Returns true if key was found and removed.
     bool remove(const T& key) {
+        BTreeMetrics::Scope metered(metrics_, BTreeMetrics::Remove);
         if (root == nullptr) {
             return false;
         }
@@ -552,17 +2022,18 @@ public:
 
         if (removed) {
             size_--;
-            // If root has no keys left, make its first child the new root
-            if (root->keys.empty()) {
-                Node* old_root = root;
-                if (root->is_leaf) {
-                    root = nullptr;
-                } else {
-                    root = root->children[0];
-                }
-                old_root->children.clear();  // Prevent recursive deletion
-                delete old_root;
+        }
+        // If root has no keys left, make its first child the new root. The
+        // descent merges children of a sparse root even when key is absent.
+        if (root->keys.empty()) {
+            Node* old_root = root;
+            if (root->is_leaf) {
+                root = nullptr;
+            } else {
+                root = root->children[0];
             }
+            old_root->children.clear();  // Prevent recursive deletion
+            delete old_root;
         }
 
         return removed;
@@ -570,12 +2041,22 @@ public:
 
     // O(log n) - Check if a key exists in the tree
     [[nodiscard]] bool search(const T& key) const noexcept {
+        BTreeMetrics::Scope metered(metrics_, BTreeMetrics::Search);
         if (root == nullptr) {
             return false;
         }
         return search_node(root, key) != nullptr;
     }
 
+    // O(log n) - search() that adds the work it does to cost
+    [[nodiscard]] bool search(const T& key, OpCost& cost) const noexcept {
+        BTreeMetrics::Scope metered(metrics_, BTreeMetrics::Search);
+        if (root == nullptr) {
+            return false;
+        }
+        return search_node(root, key, &cost) != nullptr;
+    }
+
     // O(log n) - Alias for search()
     [[nodiscard]] bool contains(const T& key) const noexcept {
         return search(key);
@@ -583,9 +2064,51 @@ public:
 
     // O(log n) lookup returning iterator to element, or end() if not found
     [[nodiscard]] iterator find(const T& key) const {
+        BTreeMetrics::Scope metered(metrics_, BTreeMetrics::Search);
         return find_impl(key);
     }
 
+    // O(log n) - find() that adds the work it does to cost
+    [[nodiscard]] iterator find(const T& key, OpCost& cost) const {
+        BTreeMetrics::Scope metered(metrics_, BTreeMetrics::Search);
+        return find_impl(key, &cost);
+    }
+
+    // O(log n) - Iterator to the first key >= key, or end()
+    [[nodiscard]] iterator lower_bound(const T& key) const {
+        return bound_impl<false>(key);
+    }
+
+    // O(log n) - Iterator to the first key > key, or end()
+    [[nodiscard]] iterator upper_bound(const T& key) const {
+        return bound_impl<true>(key);
+    }
+
+    // O(log n + limit) - Call f(key) for up to limit keys >= from, in order.
+    // Returns the number of keys visited.
+    template<typename Func>
+    size_t scan(const T& from, size_t limit, Func f) const {
+        return scan_spans(from, limit, [&f](const T* first, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                f(first[i]);
+            }
+        });
+    }
+
+    // O(log n + limit) - Like scan(), but f(const T* first, size_t count)
+    // receives contiguous runs of keys (a leaf's range, or one separator key
+    // of an internal node) so the caller can process them in bulk. Returns
+    // the number of keys visited.
+    template<typename Func>
+    size_t scan_spans(const T& from, size_t limit, Func f) const {
+        if (root == nullptr || limit == 0) {
+            return 0;
+        }
+        size_t remaining = limit;
+        scan_node(root, &from, remaining, f);
+        return limit - remaining;
+    }
+
     // O(n) - Print all keys in sorted order to stdout
     void traverse() const {
         if (root != nullptr) {
@@ -624,6 +2147,141 @@ public:
         return calculate_height(root);
     }
 
+    // O(n) - Node counts, fill and memory footprint of the tree
+    [[nodiscard]] Stats stats() const noexcept {
+        Stats result;
+        if (root != nullptr) {
+            collect_stats(root, result);
+            result.height = height();
+        }
+        return result;
+    }
+
+    // O(1) - Record operation counts, sampled latencies and rebalancing
+    // steps of insert, remove, search and find into metrics (nullptr
+    // detaches). The metrics must outlive the attachment; one BTreeMetrics
+    // may be shared by several trees.
+    void set_metrics(BTreeMetrics* metrics) noexcept {
+        metrics_ = metrics;
+    }
+
+    [[nodiscard]] BTreeMetrics* metrics() const noexcept {
+        return metrics_;
+    }
+
+    // O(1) - Choose how later inserts make room in a full node (existing
+    // nodes are left as they are). Removes work the same under both.
+    void set_split_policy(SplitPolicy policy) noexcept {
+        split_policy_ = policy;
+    }
+
+    [[nodiscard]] SplitPolicy split_policy() const noexcept {
+        return split_policy_;
+    }
+
+    // O(1) - Choose when later inserts split full nodes. Both strategies
+    // keep the same invariants, so they may be switched at any time.
+    void set_insert_strategy(InsertStrategy strategy) noexcept {
+        insert_strategy_ = strategy;
+    }
+
+    [[nodiscard]] InsertStrategy insert_strategy() const noexcept {
+        return insert_strategy_;
+    }
+
+    // O(1) - Count node visits made by search, find, bounds, scans, insert
+    // and remove from now on. Counters persist while profiling is off.
+    // Reads update the counters atomically, so concurrent readers (e.g. under
+    // a shared lock) stay safe; toggling profiling is a write.
+    void set_profiling(bool enabled) noexcept {
+        profiling_ = enabled;
+    }
+
+    [[nodiscard]] bool profiling() const noexcept {
+        return profiling_;
+    }
+
+    // O(n) - Zero every node's visit counter
+    void reset_profile() noexcept {
+        if (root != nullptr) {
+            reset_visits(root);
+        }
+    }
+
+    // O(n log n) - Visit counts per level, cold memory, and the `top` most
+    // visited subtrees with their key ranges. Subtrees are ranked at the
+    // shallowest level with at least 64 nodes (the leaves in a smaller
+    // tree), so each covers a contiguous key range of comparable size.
+    [[nodiscard]] Heatmap heatmap(size_t top = 10) const {
+        Heatmap heat;
+        if (root == nullptr) {
+            return heat;
+        }
+        collect_heat(root, 0, heat);
+
+        size_t depth = 0;
+        while (depth + 1 < heat.levels.size() && heat.levels[depth].nodes < 64) {
+            depth++;
+        }
+        std::vector<typename Heatmap::Subtree> subtrees;
+        subtrees.reserve(heat.levels[depth].nodes);
+        collect_subtrees(root, 0, depth, subtrees);
+        std::stable_sort(subtrees.begin(), subtrees.end(),
+                         [](const auto& a, const auto& b) { return a.visits > b.visits; });
+
+        uint64_t total = 0;
+        for (const auto& subtree : subtrees) {
+            total += subtree.visits;
+        }
+        uint64_t decile = 0;
+        size_t decile_count = std::max<size_t>(1, subtrees.size() / 10);
+        for (size_t i = 0; i < decile_count; i++) {
+            decile += subtrees[i].visits;
+        }
+        if (total > 0) {
+            heat.top_decile_share = static_cast<double>(decile) / static_cast<double>(total);
+            for (auto& subtree : subtrees) {
+                subtree.share = static_cast<double>(subtree.visits) / static_cast<double>(total);
+            }
+        }
+        heat.subtree_count = subtrees.size();
+        subtrees.resize(std::min(top, subtrees.size()));
+        heat.hottest = std::move(subtrees);
+        return heat;
+    }
+
+    // O(n log n) - Print heatmap(top) as a text report
+    void heatmap_report(std::ostream& os, size_t top = 10) const {
+        Heatmap heat = heatmap(top);
+        os << "BTree heatmap: " << heat.visits << " node visits, " << size_ << " keys\n";
+        os << "level   nodes      visits   visits/node   cold nodes\n";
+        for (size_t d = 0; d < heat.levels.size(); d++) {
+            const auto& level = heat.levels[d];
+            double per_node = level.nodes == 0 ? 0.0 : static_cast<double>(level.visits) / level.nodes;
+            char line[96];
+            std::snprintf(line, sizeof(line), "%5zu %7zu %11llu %13.1f %12zu\n", d, level.nodes,
+                          static_cast<unsigned long long>(level.visits), per_node, level.cold_nodes);
+            os << line;
+        }
+        char cold[96];
+        std::snprintf(cold, sizeof(cold), "cold memory: %zu of %zu bytes (%.1f%%)\n", heat.cold_bytes,
+                      heat.memory_bytes, 100.0 * heat.cold_fraction());
+        os << cold;
+        if (heat.hottest.empty()) {
+            return;
+        }
+        char skew[128];
+        std::snprintf(skew, sizeof(skew), "hottest 10%% of %zu subtrees at depth %zu take %.1f%% of their traffic\n",
+                      heat.subtree_count, heat.hottest.front().depth, 100.0 * heat.top_decile_share);
+        os << skew;
+        for (const auto& subtree : heat.hottest) {
+            char share[32];
+            std::snprintf(share, sizeof(share), "%6.2f%%", 100.0 * subtree.share);
+            os << "  " << share << "  " << subtree.visits << " visits, " << subtree.nodes << " nodes, keys ["
+               << subtree.first << ", " << subtree.last << "]\n";
+        }
+    }
+
     // O(log n) - Return the minimum element. Throws if tree is empty.
     [[nodiscard]] const T& min() const {
         if (root == nullptr) {
@@ -684,3 +2342,101 @@ public:
         return end();
     }
 };
+
+// Immutable B-tree built from a sorted std::array, usable in constexpr
+// context for static lookup tables (codes, ranges) that would otherwise be
+// populated through insert() at startup.
+//
+// Keys are laid out as an implicit tree of fixed-size blocks of Order - 1
+// keys: block b's children are blocks b * Order + 1 ... b * Order + Order,
+// so there are no child pointers and no heap allocation. Blocks are searched
+// with the same kernels as BTree nodes. Unused slots at the end of the
+// in-order sequence are left value-initialized and excluded by each block's
+// key count.
+//
+// constexpr StaticBTree<int, 4> table(std::array<int, 4>{2, 3, 5, 7});
+// static_assert(table.contains(5));
+template <typename T, size_t N, int Order = 16>
+class StaticBTree {
+    static_assert(Order >= 3, "StaticBTree order must be at least 3");
+
+    static constexpr size_t block_keys = Order - 1;
+    static constexpr size_t block_count = (N + block_keys - 1) / block_keys;
+
+    std::array<T, block_count * block_keys> keys_;
+    std::array<size_t, block_count> counts_;
+
+    static constexpr size_t child_block(size_t block, size_t index) noexcept {
+        return block * Order + index + 1;
+    }
+
+    // In-order fill: left subtree, key, ..., rightmost subtree
+    constexpr void build(const std::array<T, N>& sorted, size_t block, size_t& next) {
+        if (block >= block_count) {
+            return;
+        }
+        for (size_t i = 0; i < block_keys; i++) {
+            build(sorted, child_block(block, i), next);
+            if (next < N) {
+                keys_[block * block_keys + i] = sorted[next++];
+                counts_[block]++;
+            }
+        }
+        build(sorted, child_block(block, block_keys), next);
+    }
+
+    template <bool Upper>
+    constexpr const T* bound(const T& key) const {
+        const T* result = nullptr;
+        size_t block = 0;
+        while (block < block_count) {
+            const T* first = keys_.data() + block * block_keys;
+            size_t count = counts_[block];
+            size_t i = Upper ? btree_detail::upper_bound_index(first, count, key)
+                             : btree_detail::lower_bound_index(first, count, key);
+            if (i < count) {
+                result = first + i;
+            }
+            block = child_block(block, i);
+        }
+        return result;
+    }
+
+public:
+    // Throws std::invalid_argument if the keys are not sorted (a compile
+    // error when evaluated in a constant expression)
+    constexpr explicit StaticBTree(const std::array<T, N>& sorted) : keys_{}, counts_{} {
+        for (size_t i = 1; i < N; i++) {
+            if (sorted[i] < sorted[i - 1]) {
+                throw std::invalid_argument("StaticBTree requires sorted keys");
+            }
+        }
+        size_t next = 0;
+        build(sorted, 0, next);
+    }
+
+    // O(log n) - Check if a key exists in the table
+    [[nodiscard]] constexpr bool contains(const T& key) const {
+        const T* it = lower_bound(key);
+        return it != nullptr && !(key < *it);
+    }
+
+    // O(log n) - Smallest key >= key, or nullptr if there is none
+    [[nodiscard]] constexpr const T* lower_bound(const T& key) const {
+        return bound<false>(key);
+    }
+
+    // O(log n) - Smallest key > key, or nullptr if there is none
+    [[nodiscard]] constexpr const T* upper_bound(const T& key) const {
+        return bound<true>(key);
+    }
+
+    [[nodiscard]] static constexpr size_t size() noexcept { return N; }
+    [[nodiscard]] static constexpr bool empty() noexcept { return N == 0; }
+};
+
+// Build a StaticBTree from a sorted array, deducing key type and size
+template <int Order = 16, typename T, size_t N>
+constexpr StaticBTree<T, N, Order> make_static_btree(const std::array<T, N>& sorted) {
+    return StaticBTree<T, N, Order>(sorted);
+}
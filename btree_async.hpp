@@ -0,0 +1,394 @@
+#pragma once
+
+#include "btree.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Asynchronous operations on BTree. Callers enqueue operations and get a
+// future (or pass a completion callback) instead of blocking on the tree;
+// a shared BTreeExecutor drains each tree's queue in batches on its worker
+// threads. Compile with -pthread.
+
+// Thread pool shared by any number of AsyncBTree instances. Each queued
+// task drains one tree; a tree is scheduled at most once at a time, so its
+// operations never run on two workers concurrently.
+class BTreeExecutor {
+public:
+    struct Options {
+        size_t threads = 0;      // Worker threads; 0: hardware concurrency
+        size_t max_batch = 1024; // Operations drained per task before the tree is requeued
+    };
+
+    BTreeExecutor() : BTreeExecutor(Options{}) {}
+
+    explicit BTreeExecutor(const Options& options)
+        : max_batch_(std::max<size_t>(1, options.max_batch)) {
+        size_t threads = options.threads;
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (size_t i = 0; i < threads; i++) {
+            workers_.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    // Runs every queued task, then stops the workers
+    ~BTreeExecutor() {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    BTreeExecutor(const BTreeExecutor&) = delete;
+    BTreeExecutor& operator=(const BTreeExecutor&) = delete;
+
+    void post(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            tasks_.push_back(std::move(task));
+        }
+        wake_.notify_one();
+    }
+
+    size_t threads() const noexcept { return workers_.size(); }
+
+    size_t max_batch() const noexcept { return max_batch_; }
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex lock_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    const size_t max_batch_;
+
+    void worker_loop() {
+        std::unique_lock<std::mutex> guard(lock_);
+        while (true) {
+            wake_.wait(guard, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            std::function<void()> task = std::move(tasks_.front());
+            tasks_.pop_front();
+            guard.unlock();
+            task();
+            guard.lock();
+        }
+    }
+};
+
+// BTree whose operations are queued and executed by a BTreeExecutor.
+//
+// Operations take effect in submission order. A drain task takes a batch
+// of queued operations and runs it under the tree's lock; within a batch,
+// a run of consecutive operations of one kind is executed in key order
+// (stable, so equal keys keep submission order) to walk neighbouring keys
+// back to back; reordering such a run does not change any result. The
+// batch's completions are delivered after the lock is released.
+//
+// Completion callbacks run on an executor thread (or, if the executor
+// cannot accept a drain task, on the thread that tried to post it, which
+// drains the queue itself) and may use this tree
+// (but not wait() on it). An exception from an operation (e.g.
+// std::bad_alloc) goes to the future, or to the callback form's fail
+// handler; without one, it and any exception thrown by a callback are
+// kept, and the next wait() rethrows the first. The executor must outlive
+// the tree; the destructor waits for every queued operation to finish.
+template <typename T, int Order = 64>
+class AsyncBTree {
+    enum class Kind : uint8_t { Insert, Remove, Find, Range };
+
+    struct Op {
+        Kind kind;
+        T key;
+        size_t limit = 0;
+        std::function<void(bool)> done;                  // Insert, Remove, Find
+        std::function<void(std::vector<T>)> range_done;  // Range
+        std::function<void(std::exception_ptr)> fail;    // Futures, or a callback's fail handler
+    };
+
+    // What an operation produced, recorded under the tree's lock and
+    // delivered after it is released
+    struct Outcome {
+        bool result = false;
+        std::vector<T> keys;
+        std::exception_ptr error;
+    };
+
+    BTree<T, Order> tree_;
+    mutable std::mutex tree_lock_;
+    BTreeExecutor& executor_;
+
+    std::mutex queue_lock_;
+    std::condition_variable idle_;
+    std::deque<Op> queue_;
+    bool scheduled_ = false;     // A drain task is queued or running
+    std::exception_ptr failure_; // First failure without a handler, for wait()
+
+    void enqueue(Op op) {
+        bool schedule;
+        {
+            std::lock_guard<std::mutex> guard(queue_lock_);
+            queue_.push_back(std::move(op));
+            schedule = !scheduled_;
+            scheduled_ = true;
+        }
+        if (schedule) {
+            try {
+                executor_.post([this] { drain(); });
+            } catch (...) {
+                // The executor cannot take the task. Other submitters may
+                // have queued behind this operation already, so drain the
+                // queue on this thread instead of leaving it unscheduled.
+                drain();
+            }
+        }
+    }
+
+    static void run(BTree<T, Order>& tree, const Op& op, Outcome& outcome) noexcept {
+        try {
+            switch (op.kind) {
+                case Kind::Insert: tree.insert(op.key); outcome.result = true; break;
+                case Kind::Remove: outcome.result = tree.remove(op.key); break;
+                case Kind::Find: outcome.result = tree.search(op.key); break;
+                case Kind::Range:
+                    outcome.keys.reserve(std::min<size_t>(op.limit, 1024));
+                    tree.scan(op.key, op.limit, [&outcome](const T& key) { outcome.keys.push_back(key); });
+                    break;
+            }
+        } catch (...) {
+            outcome.error = std::current_exception();
+        }
+    }
+
+    // Delivers one outcome; called without the tree's lock
+    void complete(Op& op, Outcome& outcome) noexcept {
+        try {
+            if (outcome.error) {
+                if (!op.fail) {
+                    std::rethrow_exception(outcome.error);
+                }
+                op.fail(outcome.error);
+            } else if (op.kind == Kind::Range) {
+                op.range_done(std::move(outcome.keys));
+            } else {
+                op.done(outcome.result);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(queue_lock_);
+            if (!failure_) {
+                failure_ = std::current_exception();
+            }
+        }
+    }
+
+    // Runs a batch under the tree's lock, recording each outcome; a run of
+    // one kind is put in key order, or left in submission order if sorting
+    // throws
+    void execute(std::vector<Op>& batch, std::vector<Outcome>& outcomes) noexcept {
+        std::vector<size_t> order(batch.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        std::lock_guard<std::mutex> guard(tree_lock_);
+        for (size_t first = 0; first < batch.size();) {
+            size_t last = first + 1;
+            Kind kind = batch[first].kind;
+            if (kind != Kind::Range) {
+                while (last < batch.size() && batch[last].kind == kind) {
+                    last++;
+                }
+                auto from = order.begin() + static_cast<std::ptrdiff_t>(first);
+                auto to = order.begin() + static_cast<std::ptrdiff_t>(last);
+                try {
+                    std::stable_sort(from, to, [&batch](size_t a, size_t b) { return batch[a].key < batch[b].key; });
+                } catch (...) {
+                    for (size_t i = first; i < last; i++) {
+                        order[i] = i;
+                    }
+                }
+            }
+            for (size_t i = first; i < last; i++) {
+                run(tree_, batch[order[i]], outcomes[order[i]]);
+            }
+            first = last;
+        }
+    }
+
+    // Executes a batch and hands the rest of the queue back to the
+    // executor; if the executor cannot take it, keeps draining on this
+    // thread, so queued operations are never left without a drain
+    void drain() noexcept {
+        while (true) {
+            drain_batch();
+            {
+                std::lock_guard<std::mutex> guard(queue_lock_);
+                scheduled_ = !queue_.empty();
+                if (!scheduled_) {
+                    idle_.notify_all();
+                    return;
+                }
+            }
+            try {
+                executor_.post([this] { drain(); });
+                return;
+            } catch (...) {
+                // Run the next batch here
+            }
+        }
+    }
+
+    void drain_batch() noexcept {
+        std::vector<Op> batch;
+        std::vector<Outcome> outcomes;
+        try {
+            {
+                std::lock_guard<std::mutex> guard(queue_lock_);
+                size_t take = std::min(queue_.size(), executor_.max_batch());
+                batch.reserve(take);
+                for (size_t i = 0; i < take; i++) {
+                    batch.push_back(std::move(queue_.front()));
+                    queue_.pop_front();
+                }
+            }
+            outcomes.resize(batch.size());
+        } catch (...) {
+            // Out of memory for the batch: fail the operations taken so far
+            std::exception_ptr error = std::current_exception();
+            for (Op& op : batch) {
+                Outcome outcome;
+                outcome.error = error;
+                complete(op, outcome);
+            }
+            batch.clear();
+        }
+
+        execute(batch, outcomes);
+        for (size_t i = 0; i < batch.size(); i++) {
+            complete(batch[i], outcomes[i]);
+        }
+    }
+
+    void wait_idle() {
+        std::unique_lock<std::mutex> guard(queue_lock_);
+        idle_.wait(guard, [this] { return !scheduled_; });
+    }
+
+    template <typename R>
+    static std::function<void(std::exception_ptr)> failer(const std::shared_ptr<std::promise<R>>& promise) {
+        return [promise](std::exception_ptr error) { promise->set_exception(error); };
+    }
+
+public:
+    explicit AsyncBTree(BTreeExecutor& executor) : executor_(executor) {}
+
+    ~AsyncBTree() { wait_idle(); }
+
+    AsyncBTree(const AsyncBTree&) = delete;
+    AsyncBTree& operator=(const AsyncBTree&) = delete;
+
+    // Callback forms: done runs on an executor thread once the operation
+    // has been applied, or fail if it threw (without fail, wait() rethrows)
+
+    void async_insert(const T& key, std::function<void()> done,
+                      std::function<void(std::exception_ptr)> fail = nullptr) {
+        enqueue(Op{Kind::Insert, key, 0, [done](bool) { done(); }, nullptr, std::move(fail)});
+    }
+
+    // done(true) if an occurrence of key was removed
+    void async_remove(const T& key, std::function<void(bool)> done,
+                      std::function<void(std::exception_ptr)> fail = nullptr) {
+        enqueue(Op{Kind::Remove, key, 0, std::move(done), nullptr, std::move(fail)});
+    }
+
+    // done(true) if key exists
+    void async_find(const T& key, std::function<void(bool)> done,
+                    std::function<void(std::exception_ptr)> fail = nullptr) {
+        enqueue(Op{Kind::Find, key, 0, std::move(done), nullptr, std::move(fail)});
+    }
+
+    // done receives up to limit keys >= from, in order (as BTree::scan)
+    void async_range(const T& from, size_t limit, std::function<void(std::vector<T>)> done,
+                     std::function<void(std::exception_ptr)> fail = nullptr) {
+        enqueue(Op{Kind::Range, from, limit, nullptr, std::move(done), std::move(fail)});
+    }
+
+    // Future forms
+
+    std::future<void> async_insert(const T& key) {
+        auto promise = std::make_shared<std::promise<void>>();
+        std::future<void> result = promise->get_future();
+        enqueue(Op{Kind::Insert, key, 0, [promise](bool) { promise->set_value(); }, nullptr,
+                   failer(promise)});
+        return result;
+    }
+
+    std::future<bool> async_remove(const T& key) {
+        auto promise = std::make_shared<std::promise<bool>>();
+        std::future<bool> result = promise->get_future();
+        enqueue(Op{Kind::Remove, key, 0, [promise](bool found) { promise->set_value(found); }, nullptr,
+                   failer(promise)});
+        return result;
+    }
+
+    std::future<bool> async_find(const T& key) {
+        auto promise = std::make_shared<std::promise<bool>>();
+        std::future<bool> result = promise->get_future();
+        enqueue(Op{Kind::Find, key, 0, [promise](bool found) { promise->set_value(found); }, nullptr,
+                   failer(promise)});
+        return result;
+    }
+
+    std::future<std::vector<T>> async_range(const T& from, size_t limit) {
+        auto promise = std::make_shared<std::promise<std::vector<T>>>();
+        std::future<std::vector<T>> result = promise->get_future();
+        enqueue(Op{Kind::Range, from, limit, nullptr,
+                   [promise](std::vector<T> keys) { promise->set_value(std::move(keys)); },
+                   failer(promise)});
+        return result;
+    }
+
+    // Blocks until every operation queued so far has completed, then
+    // rethrows the first failure no fail handler took, if any. Must not be
+    // called from a completion callback.
+    void wait() {
+        wait_idle();
+        std::exception_ptr failure;
+        {
+            std::lock_guard<std::mutex> guard(queue_lock_);
+            failure = std::exchange(failure_, nullptr);
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+
+    // Number of keys after the operations applied so far
+    size_t size() const {
+        std::lock_guard<std::mutex> guard(tree_lock_);
+        return tree_.size();
+    }
+
+    // Applies f to every key in order under the tree's lock
+    template <typename Func>
+    void for_each(Func f) const {
+        std::lock_guard<std::mutex> guard(tree_lock_);
+        tree_.for_each(f);
+    }
+};
@@ -1,39 +1,35 @@
 #include "btree.hpp"
-#include <chrono>
+#include "btree_concurrent.hpp"
+#include "btree_async.hpp"
+#include "bwtree.hpp"
+#include "benchmark_harness.hpp"
 #include <random>
 #include <algorithm>
-#include <iomanip>
+#include <cmath>
 #include <limits>
 #include <set>
+#include <map>
+#include <unordered_set>
+#include <cstdint>
+#include <type_traits>
 #include <string>
+#include <tuple>
+#include <thread>
+#include <atomic>
+#include <shared_mutex>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 
-using namespace std::chrono;
-
-// Number of runs per benchmark (first run is warmup, discarded)
-constexpr int NUM_RUNS = 4;
-
-// Benchmark result structure
-struct BenchmarkResult {
-    std::string name;
-    double time_ms;
-    size_t operations;
-
-    double ops_per_sec() const {
-        return operations / (time_ms / 1000.0);
-    }
-};
-
-// Timer utility
-class Timer {
-    high_resolution_clock::time_point start_;
-public:
-    Timer() : start_(high_resolution_clock::now()) {}
-
-    double elapsed_ms() const {
-        auto end = high_resolution_clock::now();
-        return duration_cast<microseconds>(end - start_).count() / 1000.0;
-    }
-};
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
 
 // Generate random integers
 std::vector<int> generate_random(size_t n, unsigned seed = 42) {
@@ -55,6 +51,117 @@ std::vector<int> generate_sequential(size_t n) {
     return data;
 }
 
+// Generate random 64-bit integers over the full non-negative range
+std::vector<int64_t> generate_random_int64(size_t n, unsigned seed = 42) {
+    std::vector<int64_t> data(n);
+    std::mt19937_64 gen(seed);
+    std::uniform_int_distribution<int64_t> dist(0, std::numeric_limits<int64_t>::max());
+    for (size_t i = 0; i < n; i++) {
+        data[i] = dist(gen);
+    }
+    return data;
+}
+
+// Generate short identifier strings (under 24 bytes, like typical string keys)
+std::vector<std::string> generate_short_strings(size_t n, unsigned seed = 42) {
+    std::vector<std::string> data(n);
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dist(0, static_cast<int>(n * 10));
+    for (size_t i = 0; i < n; i++) {
+        data[i] = "user_" + std::to_string(dist(gen));
+    }
+    return data;
+}
+
+// Generate random alphanumeric strings of 8-32 characters
+std::vector<std::string> generate_random_strings(size_t n, unsigned seed = 42) {
+    static const char alphabet[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    std::vector<std::string> data(n);
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<size_t> length(8, 32);
+    std::uniform_int_distribution<size_t> pick(0, sizeof(alphabet) - 2);
+    for (auto& key : data) {
+        key.resize(length(gen));
+        for (char& c : key) {
+            c = alphabet[pick(gen)];
+        }
+    }
+    return data;
+}
+
+// Generate URL-like strings: long shared prefixes, so comparisons scan far
+// before the first difference
+std::vector<std::string> generate_url_strings(size_t n, unsigned seed = 42) {
+    static const char* const paths[] = {"users", "orders", "products", "sessions"};
+    std::vector<std::string> data(n);
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> path(0, 3);
+    std::uniform_int_distribution<int> id(0, static_cast<int>(n * 10));
+    for (auto& key : data) {
+        key = "https://api.example.com/v2/";
+        key += paths[path(gen)];
+        key += "/";
+        key += std::to_string(id(gen));
+        key += "/details";
+    }
+    return data;
+}
+
+// Generate strings whose lengths span 1-512 bytes (log-uniform), mixing
+// SSO and heap-allocated keys
+std::vector<std::string> generate_varying_strings(size_t n, unsigned seed = 42) {
+    std::vector<std::string> data(n);
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> log_length(0.0, std::log2(512.0));
+    std::uniform_int_distribution<int> letter('a', 'z');
+    for (auto& key : data) {
+        key.resize(static_cast<size_t>(std::exp2(log_length(gen))));
+        for (char& c : key) {
+            c = static_cast<char>(letter(gen));
+        }
+    }
+    return data;
+}
+
+// 128-bit unsigned integer key (e.g. UUIDs), compared high word first
+struct UInt128 {
+    uint64_t hi;
+    uint64_t lo;
+
+    friend bool operator<(const UInt128& a, const UInt128& b) {
+        return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo);
+    }
+    friend bool operator>(const UInt128& a, const UInt128& b) { return b < a; }
+    friend bool operator==(const UInt128& a, const UInt128& b) { return a.hi == b.hi && a.lo == b.lo; }
+    friend bool operator!=(const UInt128& a, const UInt128& b) { return !(a == b); }
+};
+
+std::vector<UInt128> generate_random_uint128(size_t n, unsigned seed = 42) {
+    std::vector<UInt128> data(n);
+    std::mt19937_64 gen(seed);
+    for (auto& key : data) {
+        key.hi = gen();
+        key.lo = gen();
+    }
+    return data;
+}
+
+// Composite (tenant, table, row) keys: few distinct leading fields, so most
+// comparisons fall through to the last one
+using TupleKey = std::tuple<int32_t, int32_t, int64_t>;
+
+std::vector<TupleKey> generate_tuples(size_t n, unsigned seed = 42) {
+    std::vector<TupleKey> data(n);
+    std::mt19937_64 gen(seed);
+    std::uniform_int_distribution<int32_t> tenant(0, 15);
+    std::uniform_int_distribution<int32_t> table(0, 7);
+    std::uniform_int_distribution<int64_t> row(0, static_cast<int64_t>(n) * 10);
+    for (auto& key : data) {
+        key = TupleKey{tenant(gen), table(gen), row(gen)};
+    }
+    return data;
+}
+
 // Print separator
 void print_separator() {
     std::cout << std::string(80, '-') << "\n";
@@ -68,225 +175,286 @@ void print_header(const std::string& title) {
     print_separator();
 }
 
-// Benchmark insert operation (runs multiple times, returns best)
+// Benchmark insert operation
 template<int Order>
 BenchmarkResult benchmark_insert_random(const std::vector<int>& data) {
-    double best_ms = std::numeric_limits<double>::max();
-    for (int run = 0; run < NUM_RUNS; run++) {
-        Timer timer;
+    return measure("BTree<" + std::to_string(Order) + "> insert random", data.size(), [&] {
         BTree<int, Order> tree;
+        Timer timer;
         for (int val : data) {
             tree.insert(val);
         }
-        double elapsed = timer.elapsed_ms();
-        if (run == 0) continue;  // Skip first run (warmup)
-        if (elapsed < best_ms) {
-            best_ms = elapsed;
-        }
-    }
-    return {"BTree<" + std::to_string(Order) + "> insert random", best_ms, data.size()};
+        return timer.elapsed_ms();
+    });
 }
 
 template<int Order>
 BenchmarkResult benchmark_insert_sequential(const std::vector<int>& data) {
-    double best_ms = std::numeric_limits<double>::max();
-    for (int run = 0; run < NUM_RUNS; run++) {
-        Timer timer;
+    return measure("BTree<" + std::to_string(Order) + "> insert sequential", data.size(), [&] {
         BTree<int, Order> tree;
+        Timer timer;
         for (int val : data) {
             tree.insert(val);
         }
-        double elapsed = timer.elapsed_ms();
-        if (run == 0) continue;  // Skip first run (warmup)
-        if (elapsed < best_ms) {
-            best_ms = elapsed;
-        }
-    }
-    return {"BTree<" + std::to_string(Order) + "> insert sequential", best_ms, data.size()};
+        return timer.elapsed_ms();
+    });
 }
 
-// Benchmark search operation (runs multiple times, returns best)
+// Benchmark search operation
 template<int Order>
 BenchmarkResult benchmark_search(BTree<int, Order>& tree, const std::vector<int>& queries) {
-    double best_ms = std::numeric_limits<double>::max();
-    for (int run = 0; run < NUM_RUNS; run++) {
+    return measure("BTree<" + std::to_string(Order) + "> search", queries.size(), [&] {
         Timer timer;
-        volatile int found = 0;  // Prevent optimization
         for (int val : queries) {
-            if (tree.search(val)) found++;
-        }
-        (void)found;  // Ensure variable is "used"
-        double elapsed = timer.elapsed_ms();
-        if (run == 0) continue;  // Skip first run (warmup)
-        if (elapsed < best_ms) {
-            best_ms = elapsed;
+            do_not_optimize(tree.search(val));
         }
-    }
-    return {"BTree<" + std::to_string(Order) + "> search", best_ms, queries.size()};
+        return timer.elapsed_ms();
+    });
 }
 
 // Benchmark find() operation (iterator-based lookup)
 template<int Order>
 BenchmarkResult benchmark_find(BTree<int, Order>& tree, const std::vector<int>& queries) {
-    double best_ms = std::numeric_limits<double>::max();
-    for (int run = 0; run < NUM_RUNS; run++) {
+    return measure("BTree<" + std::to_string(Order) + "> find", queries.size(), [&] {
         Timer timer;
-        volatile int found = 0;  // Prevent optimization
         for (int val : queries) {
-            if (tree.find(val) != tree.end()) found++;
-        }
-        (void)found;  // Ensure variable is "used"
-        double elapsed = timer.elapsed_ms();
-        if (run == 0) continue;  // Skip first run (warmup)
-        if (elapsed < best_ms) {
-            best_ms = elapsed;
+            do_not_optimize(tree.find(val) != tree.end());
         }
-    }
-    return {"BTree<" + std::to_string(Order) + "> find", best_ms, queries.size()};
+        return timer.elapsed_ms();
+    });
 }
 
-// Benchmark remove operation
+// Benchmark remove operation (tree rebuilt untimed before each sample)
 template<int Order>
 BenchmarkResult benchmark_remove(const std::vector<int>& data) {
-    BTree<int, Order> tree;
-    for (int val : data) {
-        tree.insert(val);
-    }
-
     // Shuffle for random removal order
     std::vector<int> to_remove = data;
     std::mt19937 gen(123);
     std::shuffle(to_remove.begin(), to_remove.end(), gen);
 
-    Timer timer;
-    for (int val : to_remove) {
-        tree.remove(val);
-    }
-    return {"BTree<" + std::to_string(Order) + "> remove random", timer.elapsed_ms(), data.size()};
+    return measure("BTree<" + std::to_string(Order) + "> remove random", data.size(), [&] {
+        BTree<int, Order> tree;
+        for (int val : data) {
+            tree.insert(val);
+        }
+        Timer timer;
+        for (int val : to_remove) {
+            do_not_optimize(tree.remove(val));
+        }
+        return timer.elapsed_ms();
+    });
 }
 
-// Benchmark iteration (runs multiple times, returns best)
+// Benchmark iteration
 template<int Order>
 BenchmarkResult benchmark_iterate(BTree<int, Order>& tree) {
-    double best_ms = std::numeric_limits<double>::max();
-    size_t tree_size = tree.size();
-    for (int run = 0; run < NUM_RUNS; run++) {
+    return measure("BTree<" + std::to_string(Order) + "> iterate", tree.size(), [&] {
         Timer timer;
-        volatile long sum = 0;  // Prevent optimization
+        long sum = 0;
         for (const auto& val : tree) {
             sum += val;
         }
-        (void)sum;  // Ensure variable is "used"
-        double elapsed = timer.elapsed_ms();
-        if (run == 0) continue;  // Skip first run (warmup)
-        if (elapsed < best_ms) {
-            best_ms = elapsed;
-        }
+        do_not_optimize(sum);
+        return timer.elapsed_ms();
+    });
+}
+
+// Value folded into iteration checksums so the scan can't be optimized away
+inline long key_weight(int32_t key) { return key; }
+inline long key_weight(int64_t key) { return static_cast<long>(key); }
+inline long key_weight(const std::string& key) { return static_cast<long>(key.size()); }
+inline long key_weight(const UInt128& key) { return static_cast<long>(key.lo); }
+inline long key_weight(const TupleKey& key) { return static_cast<long>(std::get<2>(key)); }
+
+// Baseline containers behind a common interface: insert, contains, find,
+// for_each, remove. Duplicates follow each container's own semantics.
+template<typename Key>
+struct SetBaseline {
+    static constexpr const char* name = "std::set";
+    std::set<Key> s;
+    void insert(const Key& key) { s.insert(key); }
+    bool contains(const Key& key) const { return s.count(key) > 0; }
+    bool find(const Key& key) const { return s.find(key) != s.end(); }
+    template<typename Func> void for_each(Func f) const { for (const Key& key : s) f(key); }
+    void remove(const Key& key) { s.erase(key); }
+};
+
+template<typename Key>
+struct MapBaseline {
+    static constexpr const char* name = "std::map";
+    std::map<Key, int> m;
+    void insert(const Key& key) { m.emplace(key, 0); }
+    bool contains(const Key& key) const { return m.count(key) > 0; }
+    bool find(const Key& key) const { return m.find(key) != m.end(); }
+    template<typename Func> void for_each(Func f) const { for (const auto& entry : m) f(entry.first); }
+    void remove(const Key& key) { m.erase(key); }
+};
+
+// Point lookups only: iteration order is unspecified
+template<typename Key>
+struct UnorderedSetBaseline {
+    static constexpr const char* name = "std::unordered_set";
+    std::unordered_set<Key> s;
+    void insert(const Key& key) { s.insert(key); }
+    bool contains(const Key& key) const { return s.count(key) > 0; }
+    bool find(const Key& key) const { return s.find(key) != s.end(); }
+    template<typename Func> void for_each(Func f) const { for (const Key& key : s) f(key); }
+    void remove(const Key& key) { s.erase(key); }
+};
+
+// Sorted std::vector searched with std::lower_bound. Single inserts and
+// removes shift O(n) elements; bulk construction is append + sort.
+template<typename Key>
+struct SortedVectorBaseline {
+    static constexpr const char* name = "sorted vector";
+    std::vector<Key> v;
+    void insert(const Key& key) { v.insert(std::lower_bound(v.begin(), v.end(), key), key); }
+    bool contains(const Key& key) const { return std::binary_search(v.begin(), v.end(), key); }
+    bool find(const Key& key) const {
+        auto it = std::lower_bound(v.begin(), v.end(), key);
+        return it != v.end() && *it == key;
+    }
+    template<typename Func> void for_each(Func f) const { for (const Key& key : v) f(key); }
+    void remove(const Key& key) {
+        auto it = std::lower_bound(v.begin(), v.end(), key);
+        if (it != v.end() && *it == key) v.erase(it);
+    }
+    void build(const std::vector<Key>& data) {
+        v = data;
+        std::sort(v.begin(), v.end());
+    }
+};
+
+template<typename Key, int Order>
+struct BTreeBaseline {
+    static inline const std::string name = "BTree<" + std::to_string(Order) + ">";
+    BTree<Key, Order> tree;
+    void insert(const Key& key) { tree.insert(key); }
+    bool contains(const Key& key) const { return tree.search(key); }
+    bool find(const Key& key) const { return tree.find(key) != tree.end(); }
+    template<typename Func> void for_each(Func f) const { for (const Key& key : tree) f(key); }
+    void remove(const Key& key) { tree.remove(key); }
+};
+
+// Above this size, single-element inserts/removes into a sorted vector are
+// quadratic and are not run
+constexpr size_t SORTED_VECTOR_INCREMENTAL_LIMIT = 100000;
+
+template<typename Container, typename Key>
+Container build_container(const std::vector<Key>& data) {
+    Container c;
+    for (const Key& key : data) {
+        c.insert(key);
     }
-    return {"BTree<" + std::to_string(Order) + "> iterate", best_ms, tree_size};
+    return c;
 }
 
-// Benchmark std::set for comparison (runs multiple times, returns best)
-BenchmarkResult benchmark_set_insert(const std::vector<int>& data) {
-    double best_ms = std::numeric_limits<double>::max();
-    for (int run = 0; run < NUM_RUNS; run++) {
+template<typename Container, typename Key>
+BenchmarkResult benchmark_container_insert(const std::vector<Key>& data) {
+    return measure(std::string(Container::name) + " insert", data.size(), [&] {
         Timer timer;
-        std::set<int> s;
-        for (int val : data) {
-            s.insert(val);
-        }
+        Container c = build_container<Container>(data);
         double elapsed = timer.elapsed_ms();
-        if (run == 0) continue;  // Skip first run (warmup)
-        if (elapsed < best_ms) {
-            best_ms = elapsed;
-        }
-    }
-    return {"std::set insert", best_ms, data.size()};
+        do_not_optimize(c);
+        return elapsed;
+    });
 }
 
-BenchmarkResult benchmark_set_search(std::set<int>& s, const std::vector<int>& queries) {
-    double best_ms = std::numeric_limits<double>::max();
-    for (int run = 0; run < NUM_RUNS; run++) {
+template<typename Key>
+BenchmarkResult benchmark_sorted_vector_build(const std::vector<Key>& data) {
+    return measure("sorted vector build (sort)", data.size(), [&] {
+        SortedVectorBaseline<Key> c;
         Timer timer;
-        volatile int found = 0;
-        for (int val : queries) {
-            if (s.count(val) > 0) found++;
-        }
-        (void)found;  // Ensure variable is "used"
+        c.build(data);
         double elapsed = timer.elapsed_ms();
-        if (run == 0) continue;  // Skip first run (warmup)
-        if (elapsed < best_ms) {
-            best_ms = elapsed;
-        }
-    }
-    return {"std::set search", best_ms, queries.size()};
+        do_not_optimize(c);
+        return elapsed;
+    });
 }
 
-BenchmarkResult benchmark_set_find(std::set<int>& s, const std::vector<int>& queries) {
-    double best_ms = std::numeric_limits<double>::max();
-    for (int run = 0; run < NUM_RUNS; run++) {
+template<typename Container, typename Key>
+BenchmarkResult benchmark_container_search(const Container& c, const std::vector<Key>& queries) {
+    return measure(std::string(Container::name) + " search", queries.size(), [&] {
         Timer timer;
-        volatile int found = 0;
-        for (int val : queries) {
-            if (s.find(val) != s.end()) found++;
+        for (const Key& key : queries) {
+            do_not_optimize(c.contains(key));
         }
-        (void)found;  // Ensure variable is "used"
-        double elapsed = timer.elapsed_ms();
-        if (run == 0) continue;  // Skip first run (warmup)
-        if (elapsed < best_ms) {
-            best_ms = elapsed;
+        return timer.elapsed_ms();
+    });
+}
+
+template<typename Container, typename Key>
+BenchmarkResult benchmark_container_find(const Container& c, const std::vector<Key>& queries) {
+    return measure(std::string(Container::name) + " find", queries.size(), [&] {
+        Timer timer;
+        for (const Key& key : queries) {
+            do_not_optimize(c.find(key));
         }
-    }
-    return {"std::set find", best_ms, queries.size()};
+        return timer.elapsed_ms();
+    });
 }
 
-BenchmarkResult benchmark_set_remove(const std::vector<int>& data) {
-    std::set<int> s;
-    for (int val : data) {
-        s.insert(val);
-    }
+template<typename Container>
+BenchmarkResult benchmark_container_iterate(const Container& c, size_t count) {
+    return measure(std::string(Container::name) + " iterate", count, [&] {
+        Timer timer;
+        long sum = 0;
+        c.for_each([&sum](const auto& key) { sum += key_weight(key); });
+        do_not_optimize(sum);
+        return timer.elapsed_ms();
+    });
+}
 
-    std::vector<int> to_remove = data;
+template<typename Container, typename Key>
+BenchmarkResult benchmark_container_remove(const std::vector<Key>& data) {
+    std::vector<Key> to_remove = data;
     std::mt19937 gen(123);
     std::shuffle(to_remove.begin(), to_remove.end(), gen);
 
-    Timer timer;
-    for (int val : to_remove) {
-        s.erase(val);
-    }
-    return {"std::set remove", timer.elapsed_ms(), data.size()};
-}
-
-BenchmarkResult benchmark_set_iterate(std::set<int>& s) {
-    double best_ms = std::numeric_limits<double>::max();
-    size_t set_size = s.size();
-    for (int run = 0; run < NUM_RUNS; run++) {
+    return measure(std::string(Container::name) + " remove", data.size(), [&] {
+        Container c = build_container<Container>(data);
         Timer timer;
-        volatile long sum = 0;
-        for (const auto& val : s) {
-            sum += val;
+        for (const Key& key : to_remove) {
+            c.remove(key);
         }
-        (void)sum;  // Ensure variable is "used"
         double elapsed = timer.elapsed_ms();
-        if (run == 0) continue;  // Skip first run (warmup)
-        if (elapsed < best_ms) {
-            best_ms = elapsed;
-        }
-    }
-    return {"std::set iterate", best_ms, set_size};
+        do_not_optimize(c);
+        return elapsed;
+    });
 }
 
-// Print result
-void print_result(const BenchmarkResult& r) {
-    std::cout << std::left << std::setw(40) << r.name
-              << std::right << std::setw(12) << std::fixed << std::setprecision(2) << r.time_ms << " ms"
-              << std::setw(15) << static_cast<long>(r.ops_per_sec()) << " ops/sec\n";
+// Benchmark insert and search on string-like keys
+template<typename Key, int Order>
+std::pair<BenchmarkResult, BenchmarkResult> benchmark_string_keys(const std::string& label,
+                                                                  const std::vector<Key>& data) {
+    std::string prefix = "BTree<" + label + ", " + std::to_string(Order) + "> ";
+    BenchmarkResult insert = measure(prefix + "insert", data.size(), [&] {
+        BTree<Key, Order> tree;
+        Timer timer;
+        for (const Key& key : data) {
+            tree.insert(key);
+        }
+        return timer.elapsed_ms();
+    });
+
+    BTree<Key, Order> tree;
+    for (const Key& key : data) {
+        tree.insert(key);
+    }
+    BenchmarkResult search = measure(prefix + "search", data.size(), [&] {
+        Timer timer;
+        for (const Key& key : data) {
+            do_not_optimize(tree.search(key));
+        }
+        return timer.elapsed_ms();
+    });
+    return {insert, search};
 }
 
 // Run all benchmarks for a given size
 template<int Order>
 void run_benchmarks_for_order(size_t /*n*/, const std::vector<int>& random_data, const std::vector<int>& seq_data) {
-    std::cout << "\n=== Order " << Order << " ===\n";
+    begin_group("Order " + std::to_string(Order));
 
     // Insert benchmarks
     print_result(benchmark_insert_random<Order>(random_data));
@@ -313,50 +481,1224 @@ void run_benchmarks_for_order(size_t /*n*/, const std::vector<int>& random_data,
     }
 }
 
-void run_set_benchmarks(size_t /*n*/, const std::vector<int>& random_data) {
-    std::cout << "\n=== std::set (baseline) ===\n";
+// Load a batch into a tree already holding as many keys: one insert() per
+// key against parallel_insert_batch() at several thread counts. The
+// existing tree is rebuilt untimed before each sample.
+template<int Order>
+void run_batch_insert_benchmarks(const std::vector<int>& random_data) {
+    begin_group("Batch insert (Order " + std::to_string(Order) + ")");
 
-    print_result(benchmark_set_insert(random_data));
+    size_t half = random_data.size() / 2;
+    std::vector<int> existing(random_data.begin(), random_data.begin() + half);
+    std::sort(existing.begin(), existing.end());
+    std::vector<int> batch(random_data.begin() + half, random_data.end());
 
-    std::set<int> s;
-    for (int val : random_data) {
-        s.insert(val);
+    print_result(measure("insert() loop", batch.size(), [&] {
+        auto tree = BTree<int, Order>::from_sorted(existing);
+        Timer timer;
+        for (int key : batch) {
+            tree.insert(key);
+        }
+        return timer.elapsed_ms();
+    }));
+
+    size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::set<size_t> thread_counts = {1, 2, 4, hardware};
+    for (size_t threads : thread_counts) {
+        print_result(measure("parallel_insert_batch " + std::to_string(threads) + " thread" +
+                             (threads > 1 ? "s" : ""), batch.size(), [&] {
+            auto tree = BTree<int, Order>::from_sorted(existing);
+            Timer timer;
+            tree.parallel_insert_batch(batch, threads);
+            return timer.elapsed_ms();
+        }));
+    }
+}
+
+// Split policies and insert strategies: random insert time, then lookups
+// and structure of the resulting tree
+template<int Order>
+void run_insert_mode_benchmarks(const std::vector<int>& random_data) {
+    begin_group("Insert modes (Order " + std::to_string(Order) + ")");
+    struct Mode {
+        std::string label;
+        SplitPolicy policy;
+        InsertStrategy strategy;
+    };
+    const Mode modes[] = {
+        {"preemptive even", SplitPolicy::Even, InsertStrategy::Preemptive},
+        {"preemptive redistribute", SplitPolicy::Redistribute, InsertStrategy::Preemptive},
+        {"bottom-up even", SplitPolicy::Even, InsertStrategy::BottomUp},
+    };
+    for (const Mode& mode : modes) {
+        auto configure = [&](BTree<int, Order>& tree) {
+            tree.set_split_policy(mode.policy);
+            tree.set_insert_strategy(mode.strategy);
+        };
+        print_result(measure("insert random, " + mode.label, random_data.size(), [&] {
+            BTree<int, Order> tree;
+            configure(tree);
+            Timer timer;
+            for (int key : random_data) {
+                tree.insert(key);
+            }
+            return timer.elapsed_ms();
+        }));
+
+        BTree<int, Order> tree;
+        configure(tree);
+        for (int key : random_data) {
+            tree.insert(key);
+        }
+        print_result(measure("search, " + mode.label, random_data.size(), [&] {
+            Timer timer;
+            size_t hits = 0;
+            for (int key : random_data) {
+                hits += tree.search(key);
+            }
+            do_not_optimize(hits);
+            return timer.elapsed_ms();
+        }));
+        auto stats = tree.stats();
+        std::cout << "  " << mode.label << ": " << stats.nodes << " nodes, fill " << std::fixed
+                  << std::setprecision(3) << stats.average_fill() << ", height " << stats.height << ", "
+                  << std::setprecision(1) << stats.memory_bytes / 1048576.0 << " MB\n";
+    }
+}
+
+// Order 512 int trees opt in to the sampled node index (two cache lines
+// of samples); Order 511 keeps the default binary search as the baseline
+template <>
+struct BTreeNodeIndex<int, 512> {
+    static constexpr size_t samples = 32;
+};
+
+// Page-sized nodes with and without the per-node sample index: random
+// insert, search and remove
+void run_node_index_benchmarks(const std::vector<int>& random_data) {
+    begin_group("Node index (Order 512)");
+    auto run = [&](const std::string& label, auto make) {
+        print_result(measure("insert random, " + label, random_data.size(), [&] {
+            auto tree = make();
+            Timer timer;
+            for (int key : random_data) {
+                tree.insert(key);
+            }
+            return timer.elapsed_ms();
+        }));
+
+        auto tree = make();
+        for (int key : random_data) {
+            tree.insert(key);
+        }
+        print_result(measure("search, " + label, random_data.size(), [&] {
+            Timer timer;
+            size_t hits = 0;
+            for (int key : random_data) {
+                hits += tree.search(key);
+            }
+            do_not_optimize(hits);
+            return timer.elapsed_ms();
+        }));
+
+        print_result(measure("remove random, " + label, random_data.size(), [&] {
+            auto copy = make();
+            for (int key : random_data) {
+                copy.insert(key);
+            }
+            Timer timer;
+            for (int key : random_data) {
+                copy.remove(key);
+            }
+            return timer.elapsed_ms();
+        }));
+    };
+    run("binary search", [] { return BTree<int, 511>(); });
+    run("sampled index", [] { return BTree<int, 512>(); });
+}
+
+// Cost of the opt-in instrumentation on lookups: detached, metrics attached
+// (every call counted, 1 in 16 timed) and profiling on
+template<int Order>
+void run_instrumentation_benchmarks(const std::vector<int>& random_data) {
+    begin_group("Instrumentation overhead (Order " + std::to_string(Order) + ")");
+    auto tree = BTree<int, Order>::from_sorted([&] {
+        std::vector<int> keys = random_data;
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }());
+
+    auto lookups = [&](const std::string& name) {
+        print_result(measure(name, random_data.size(), [&] {
+            Timer timer;
+            size_t hits = 0;
+            for (int key : random_data) {
+                hits += tree.search(key);
+            }
+            do_not_optimize(hits);
+            return timer.elapsed_ms();
+        }));
+    };
+
+    lookups("search");
+    BTreeMetrics metrics;
+    tree.set_metrics(&metrics);
+    lookups("search, metrics attached");
+    tree.set_metrics(nullptr);
+    tree.set_profiling(true);
+    lookups("search, profiling on");
+    tree.set_profiling(false);
+}
+
+// Run every operation against one container type
+template<typename Container, typename Key>
+void run_container_benchmarks(const std::vector<Key>& data) {
+    constexpr bool is_sorted_vector = std::is_same_v<Container, SortedVectorBaseline<Key>>;
+    bool incremental = !is_sorted_vector || data.size() <= SORTED_VECTOR_INCREMENTAL_LIMIT;
+
+    if constexpr (is_sorted_vector) {
+        print_result(benchmark_sorted_vector_build(data));
+    }
+    if (incremental) {
+        print_result(benchmark_container_insert<Container>(data));
+    }
+
+    Container c;
+    if constexpr (is_sorted_vector) {
+        c.build(data);
+    } else {
+        c = build_container<Container>(data);
+    }
+
+    print_result(benchmark_container_search(c, data));
+    print_result(benchmark_container_find(c, data));
+    print_result(benchmark_container_iterate(c, data.size()));
+
+    if (incremental) {
+        print_result(benchmark_container_remove<Container>(data));
+    } else {
+        std::cout << Container::name << " insert/remove skipped above "
+                  << SORTED_VECTOR_INCREMENTAL_LIMIT << " elements (quadratic)\n";
+    }
+}
+
+// Compare BTree with standard containers for one key type
+template<typename Key>
+void run_baseline_benchmarks(const std::string& key_label, const std::vector<Key>& data) {
+    begin_group("Baselines (" + key_label + ")");
+
+    run_container_benchmarks<BTreeBaseline<Key, 10>>(data);
+    run_container_benchmarks<BTreeBaseline<Key, 50>>(data);
+    run_container_benchmarks<SetBaseline<Key>>(data);
+    run_container_benchmarks<MapBaseline<Key>>(data);
+    run_container_benchmarks<SortedVectorBaseline<Key>>(data);
+    run_container_benchmarks<UnorderedSetBaseline<Key>>(data);
+}
+
+// Compare heap/SSO std::string keys with inline FixedString keys
+void run_short_string_benchmarks(size_t n) {
+    begin_group("Short string keys");
+
+    auto strings = generate_short_strings(n);
+    std::vector<FixedString<23>> fixed(strings.begin(), strings.end());
+
+    auto string_results = benchmark_string_keys<std::string, 10>("string", strings);
+    print_result(string_results.first);
+    print_result(string_results.second);
+
+    auto fixed_results = benchmark_string_keys<FixedString<23>, 10>("FixedString<23>", fixed);
+    print_result(fixed_results.first);
+    print_result(fixed_results.second);
+
+    // Order sized for ~1 KiB key arrays
+    constexpr int sized_order = node_order_for<FixedString<23>, 1024>;
+    auto sized_results = benchmark_string_keys<FixedString<23>, sized_order>("FixedString<23>", fixed);
+    print_result(sized_results.first);
+    print_result(sized_results.second);
+}
+
+// Every container operation for one key type on BTree and std::set, plus
+// insertion in sorted order
+template<typename Key>
+void run_key_type_benchmarks(const std::string& key_label, const std::vector<Key>& data) {
+    begin_group("Key type (" + key_label + ")");
+
+    std::vector<Key> sorted = data;
+    std::sort(sorted.begin(), sorted.end());
+    print_result(measure("BTree<50> insert sorted", sorted.size(), [&] {
+        Timer timer;
+        auto c = build_container<BTreeBaseline<Key, 50>>(sorted);
+        double elapsed = timer.elapsed_ms();
+        do_not_optimize(c);
+        return elapsed;
+    }));
+
+    run_container_benchmarks<BTreeBaseline<Key, 10>>(data);
+    run_container_benchmarks<BTreeBaseline<Key, 50>>(data);
+    run_container_benchmarks<SetBaseline<Key>>(data);
+}
+
+void run_all_key_type_benchmarks(size_t n) {
+    run_key_type_benchmarks<std::string>("random string", generate_random_strings(n));
+    run_key_type_benchmarks<std::string>("URL string", generate_url_strings(n));
+    run_key_type_benchmarks<std::string>("varying-length string", generate_varying_strings(n));
+    run_key_type_benchmarks<int64_t>("int64", generate_random_int64(n));
+    run_key_type_benchmarks<UInt128>("uint128", generate_random_uint128(n));
+    run_key_type_benchmarks<TupleKey>("tuple<int32, int32, int64>", generate_tuples(n));
+}
+
+// ---------------------------------------------------------------------------
+// Rebalancing micro-benchmarks: split_child, merge_children and the two
+// borrows, each applied once to many independently built parent/children
+// fixtures so descent cost is excluded entirely.
+// ---------------------------------------------------------------------------
+
+template<typename T, int Order>
+struct BTreeInspector<BTree<T, Order>> {
+    using Tree = BTree<T, Order>;
+    using Node = typename Tree::Node;
+    static constexpr int max_keys = Tree::max_keys;
+    static constexpr int min_keys = Tree::min_keys;
+
+    static void split_child(Tree& tree, Node* parent, size_t index) { tree.split_child(parent, index); }
+    static void merge_children(Tree& tree, Node* parent, size_t index) { tree.merge_children(parent, index); }
+    static void borrow_from_prev(Tree& tree, Node* parent, size_t index) { tree.borrow_from_prev(parent, index); }
+    static void borrow_from_next(Tree& tree, Node* parent, size_t index) { tree.borrow_from_next(parent, index); }
+};
+
+// Ordered keys for fixtures: key_value<Key>(i) < key_value<Key>(j) iff i < j
+template<typename Key>
+Key key_value(size_t i) {
+    if constexpr (std::is_integral_v<Key>) {
+        return static_cast<Key>(i);
+    } else {
+        std::string digits = std::to_string(i);
+        return Key("key_" + std::string(12 - digits.size(), '0') + digits);
+    }
+}
+
+// Builds parent nodes whose children hold the requested key counts. With
+// internal=true each child is an internal node whose child pointers all
+// refer to one shared empty leaf, so the child-pointer moves of each
+// primitive are included without allocating a leaf per pointer.
+template<typename Key, int Order>
+struct RebalanceFixture {
+    using Inspector = BTreeInspector<BTree<Key, Order>>;
+    using Node = typename Inspector::Node;
+
+    static Node* make_child(size_t first_key, size_t count, bool internal) {
+        Node* node = new Node(!internal);
+        for (size_t i = 0; i < count; i++) {
+            node->keys.push_back(key_value<Key>(first_key + 2 * i));
+        }
+        if (internal) {
+            node->children.assign(count + 1, shared_leaf());
+        }
+        return node;
+    }
+
+    static Node* shared_leaf() {
+        static Node leaf(true);
+        return &leaf;
+    }
+
+    // Detach the shared leaf before deleting, since nodes own their children
+    static void destroy(Node* parent) {
+        for (Node* child : parent->children) {
+            if (!child->is_leaf) {
+                child->children.clear();
+            }
+        }
+        delete parent;
+    }
+
+    // Parent with one separator key between two children of the given sizes
+    static Node* make_pair(size_t left_keys, size_t right_keys, bool internal) {
+        Node* parent = new Node(false);
+        parent->children.push_back(make_child(0, left_keys, internal));
+        size_t separator = 2 * left_keys;
+        parent->keys.push_back(key_value<Key>(separator));
+        parent->children.push_back(make_child(separator + 1, right_keys, internal));
+        return parent;
+    }
+
+    // Parent with a single full child, ready for split_child
+    static Node* make_full(bool internal) {
+        Node* parent = new Node(false);
+        parent->children.push_back(make_child(0, Inspector::max_keys, internal));
+        return parent;
+    }
+};
+
+// Number of fixtures per sample: enough work to time, bounded memory
+template<typename Key, int Order>
+size_t rebalance_fixture_count() {
+    size_t per_fixture = 2 * static_cast<size_t>(Order) * (sizeof(Key) + sizeof(void*));
+    return std::clamp<size_t>((8u << 20) / per_fixture, 256, 20000);
+}
+
+template<typename Key, int Order, typename Make, typename Apply>
+BenchmarkResult benchmark_rebalance_op(const std::string& name, Make make, Apply apply) {
+    using Fixture = RebalanceFixture<Key, Order>;
+    using Node = typename Fixture::Node;
+    size_t count = rebalance_fixture_count<Key, Order>();
+
+    return measure(name, count, [&] {
+        BTree<Key, Order> tree;
+        std::vector<Node*> parents(count);
+        for (auto& parent : parents) {
+            parent = make();
+        }
+        Timer timer;
+        for (Node* parent : parents) {
+            apply(tree, parent);
+        }
+        double elapsed = timer.elapsed_ms();
+        clobber_memory();
+        for (Node* parent : parents) {
+            Fixture::destroy(parent);
+        }
+        return elapsed;
+    });
+}
+
+template<typename Key, int Order>
+void run_rebalance_benchmarks_for(const std::string& key_label) {
+    using Fixture = RebalanceFixture<Key, Order>;
+    using Inspector = typename Fixture::Inspector;
+    using Tree = BTree<Key, Order>;
+    using Node = typename Fixture::Node;
+    constexpr size_t max_keys = Inspector::max_keys;
+    constexpr size_t min_keys = Inspector::min_keys;
+
+    begin_group("Rebalancing (" + key_label + ", Order " + std::to_string(Order) + ")");
+    set_benchmark_size(rebalance_fixture_count<Key, Order>());
+
+    for (bool internal : {false, true}) {
+        std::string level = internal ? " internal" : " leaf";
+
+        print_result(benchmark_rebalance_op<Key, Order>("split_child" + level,
+            [&] { return Fixture::make_full(internal); },
+            [](Tree& tree, Node* parent) { Inspector::split_child(tree, parent, 0); }));
+
+        // left + separator + right == max_keys: merged node fits
+        print_result(benchmark_rebalance_op<Key, Order>("merge_children" + level,
+            [&] { return Fixture::make_pair(min_keys, max_keys - 1 - min_keys, internal); },
+            [](Tree& tree, Node* parent) { Inspector::merge_children(tree, parent, 0); }));
+
+        // left + separator + right == max_keys + 1: merge then re-split
+        print_result(benchmark_rebalance_op<Key, Order>("merge_children overflow" + level,
+            [&] { return Fixture::make_pair(min_keys, max_keys - min_keys, internal); },
+            [](Tree& tree, Node* parent) { Inspector::merge_children(tree, parent, 0); }));
+
+        // Underfull child at min_keys next to a full sibling, as fill_child sees it
+        print_result(benchmark_rebalance_op<Key, Order>("borrow_from_prev" + level,
+            [&] { return Fixture::make_pair(max_keys, min_keys, internal); },
+            [](Tree& tree, Node* parent) { Inspector::borrow_from_prev(tree, parent, 1); }));
+
+        print_result(benchmark_rebalance_op<Key, Order>("borrow_from_next" + level,
+            [&] { return Fixture::make_pair(min_keys, max_keys, internal); },
+            [](Tree& tree, Node* parent) { Inspector::borrow_from_next(tree, parent, 0); }));
+    }
+}
+
+template<typename Key>
+void run_rebalance_benchmarks(const std::string& key_label) {
+    run_rebalance_benchmarks_for<Key, 4>(key_label);
+    run_rebalance_benchmarks_for<Key, 16>(key_label);
+    run_rebalance_benchmarks_for<Key, 64>(key_label);
+    run_rebalance_benchmarks_for<Key, 256>(key_label);
+}
+
+// ---------------------------------------------------------------------------
+// Steady-state churn: the tree is held at a constant size by replacing a
+// random live key (remove, then insert a fresh random key) for a long time,
+// sampling throughput, latency percentiles, node fill and memory at fixed
+// intervals to expose degradation that one-shot phases never reach.
+// ---------------------------------------------------------------------------
+
+struct ChurnConfig {
+    size_t size = 1000000;
+    double duration_s = 600;
+    double interval_s = 10;
+    int order = 50;
+};
+
+template<int Order>
+void run_churn_benchmark(const ChurnConfig& churn) {
+    using clock = std::chrono::steady_clock;
+
+    begin_group("Churn (Order " + std::to_string(Order) + ", " + std::to_string(churn.size) + " keys)");
+
+    std::mt19937_64 gen(42);
+    std::vector<int64_t> live(churn.size);
+    BTree<int64_t, Order> tree;
+    for (auto& key : live) {
+        key = static_cast<int64_t>(gen() >> 1);
+        tree.insert(key);
+    }
+    std::uniform_int_distribution<size_t> pick(0, churn.size - 1);
+
+    auto initial = tree.stats();
+    std::cout << "Initial: " << initial.nodes << " nodes, fill " << std::fixed << std::setprecision(3)
+              << initial.average_fill() << ", height " << initial.height << "\n";
+    std::cout << std::right << std::setw(8) << "time s" << std::setw(13) << "ops/sec"
+              << std::setw(10) << "ins p50" << std::setw(10) << "ins p99" << std::setw(11) << "ins p99.9"
+              << std::setw(10) << "rem p50" << std::setw(10) << "rem p99" << std::setw(11) << "rem p99.9"
+              << std::setw(8) << "fill" << std::setw(11) << "nodes" << std::setw(10) << "tree MB"
+              << std::setw(9) << "RSS MB" << "\n";
+
+    LatencyHistogram insert_latency;
+    LatencyHistogram remove_latency;
+    double elapsed_s = 0;
+    while (elapsed_s < churn.duration_s) {
+        insert_latency.clear();
+        remove_latency.clear();
+        size_t ops = 0;
+        auto interval_start = clock::now();
+        auto interval_end = interval_start + std::chrono::duration<double>(churn.interval_s);
+        auto now = interval_start;
+
+        while (now < interval_end) {
+            // Check the clock every batch; per-op timestamps double as latency probes
+            for (int batch = 0; batch < 256; batch++) {
+                size_t slot = pick(gen);
+                int64_t fresh = static_cast<int64_t>(gen() >> 1);
+
+                auto t0 = clock::now();
+                do_not_optimize(tree.remove(live[slot]));
+                auto t1 = clock::now();
+                tree.insert(fresh);
+                auto t2 = clock::now();
+
+                live[slot] = fresh;
+                remove_latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+                insert_latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count());
+                now = t2;
+            }
+            ops += 2 * 256;
+        }
+        double interval_s = std::chrono::duration<double>(now - interval_start).count();
+        elapsed_s += interval_s;
+
+        // Structural sample, outside the timed interval
+        auto stats = tree.stats();
+        std::cout << std::fixed << std::setprecision(0) << std::setw(8) << elapsed_s
+                  << std::setw(13) << static_cast<long>(static_cast<double>(ops) / interval_s)
+                  << std::setw(10) << insert_latency.percentile(0.5)
+                  << std::setw(10) << insert_latency.percentile(0.99)
+                  << std::setw(11) << insert_latency.percentile(0.999)
+                  << std::setw(10) << remove_latency.percentile(0.5)
+                  << std::setw(10) << remove_latency.percentile(0.99)
+                  << std::setw(11) << remove_latency.percentile(0.999)
+                  << std::setprecision(3) << std::setw(8) << stats.average_fill()
+                  << std::setw(11) << stats.nodes
+                  << std::setprecision(1) << std::setw(10) << stats.memory_bytes / 1048576.0
+                  << std::setw(9) << current_rss_bytes() / 1048576.0 << "\n";
+    }
+    std::cout << "Latencies in ns; tree MB counts node objects and reserved key/child storage\n";
+}
+
+void run_churn_benchmark(const ChurnConfig& churn) {
+    switch (churn.order) {
+        case 10: run_churn_benchmark<10>(churn); break;
+        case 50: run_churn_benchmark<50>(churn); break;
+        case 100: run_churn_benchmark<100>(churn); break;
+        default: throw std::invalid_argument("churn order must be 10, 50 or 100");
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Range scans of a fixed length starting at random keys: iterator-based
+// (lower_bound + ++), callback-based (scan) and span-based (scan_spans),
+// against std::set. Each operation is one scan.
+// ---------------------------------------------------------------------------
+
+// Enough scans per sample that every scan length touches ~1M keys
+size_t scans_per_sample(size_t scan_length) {
+    return std::max<size_t>(200, 1000000 / scan_length);
+}
+
+template<int Order>
+BenchmarkResult benchmark_scan_iterator(const BTree<int, Order>& tree, const std::vector<int>& starts,
+                                        size_t length) {
+    return measure("BTree<" + std::to_string(Order) + "> iterator scan " + std::to_string(length),
+                   starts.size(), [&] {
+        Timer timer;
+        for (int start : starts) {
+            long sum = 0;
+            size_t visited = 0;
+            for (auto it = tree.lower_bound(start); it != tree.end() && visited < length; ++it, ++visited) {
+                sum += *it;
+            }
+            do_not_optimize(sum);
+        }
+        return timer.elapsed_ms();
+    });
+}
+
+template<int Order>
+BenchmarkResult benchmark_scan_callback(const BTree<int, Order>& tree, const std::vector<int>& starts,
+                                        size_t length) {
+    return measure("BTree<" + std::to_string(Order) + "> callback scan " + std::to_string(length),
+                   starts.size(), [&] {
+        Timer timer;
+        for (int start : starts) {
+            long sum = 0;
+            tree.scan(start, length, [&sum](int key) { sum += key; });
+            do_not_optimize(sum);
+        }
+        return timer.elapsed_ms();
+    });
+}
+
+template<int Order>
+BenchmarkResult benchmark_scan_spans(const BTree<int, Order>& tree, const std::vector<int>& starts,
+                                     size_t length) {
+    return measure("BTree<" + std::to_string(Order) + "> span scan " + std::to_string(length),
+                   starts.size(), [&] {
+        Timer timer;
+        for (int start : starts) {
+            long sum = 0;
+            tree.scan_spans(start, length, [&sum](const int* first, size_t count) {
+                for (size_t i = 0; i < count; i++) {
+                    sum += first[i];
+                }
+            });
+            do_not_optimize(sum);
+        }
+        return timer.elapsed_ms();
+    });
+}
+
+BenchmarkResult benchmark_set_scan(const std::set<int>& s, const std::vector<int>& starts, size_t length) {
+    return measure("std::set scan " + std::to_string(length), starts.size(), [&] {
+        Timer timer;
+        for (int start : starts) {
+            long sum = 0;
+            size_t visited = 0;
+            for (auto it = s.lower_bound(start); it != s.end() && visited < length; ++it, ++visited) {
+                sum += *it;
+            }
+            do_not_optimize(sum);
+        }
+        return timer.elapsed_ms();
+    });
+}
+
+template<int Order>
+void run_range_scan_benchmarks_for(const std::vector<int>& data, const std::vector<size_t>& lengths,
+                                   const std::vector<std::vector<int>>& starts) {
+    BTree<int, Order> tree;
+    for (int val : data) {
+        tree.insert(val);
+    }
+    for (size_t i = 0; i < lengths.size(); i++) {
+        print_result(benchmark_scan_iterator<Order>(tree, starts[i], lengths[i]));
+        print_result(benchmark_scan_callback<Order>(tree, starts[i], lengths[i]));
+        print_result(benchmark_scan_spans<Order>(tree, starts[i], lengths[i]));
+    }
+}
+
+void run_range_scan_benchmarks(const std::vector<int>& data) {
+    begin_group("Range scans");
+
+    const std::vector<size_t> lengths = {10, 100, 10000};
+    std::vector<std::vector<int>> starts;
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<size_t> pick(0, data.size() - 1);
+    for (size_t length : lengths) {
+        std::vector<int> s(scans_per_sample(length));
+        for (auto& start : s) {
+            start = data[pick(gen)];
+        }
+        starts.push_back(std::move(s));
+    }
+
+    run_range_scan_benchmarks_for<10>(data, lengths, starts);
+    run_range_scan_benchmarks_for<50>(data, lengths, starts);
+
+    std::set<int> s(data.begin(), data.end());
+    for (size_t i = 0; i < lengths.size(); i++) {
+        print_result(benchmark_set_scan(s, starts[i], lengths[i]));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Startup: time until a tree of n keys is ready to serve, via each way of
+// building one (repeated insert from random or sorted keys, sort + bulk
+// build, bulk build from sorted keys, deserializing a file, and attaching to
+// a memory-mapped serialized file). Each sample runs in a fresh forked
+// process so peak RSS is that build's alone and no allocator state carries
+// over between samples.
+// ---------------------------------------------------------------------------
+
+constexpr int STARTUP_ORDER = 50;
+using StartupTree = BTree<int, STARTUP_ORDER>;
+
+struct StartupSample {
+    double time_ms;
+    size_t peak_rss_bytes;  // Peak RSS growth during the build; 0 if unknown
+};
+
+template<typename Build>
+StartupSample measure_startup(Build& build) {
+#if defined(__GLIBC__)
+    malloc_trim(0);  // Freed heap pages would otherwise be reused without counting
+#endif
+    size_t base_rss = current_rss_bytes();
+    bool peak_reset = reset_peak_rss();
+    Timer timer;
+    StartupTree tree = build();
+    do_not_optimize(tree.size());
+    double ms = timer.elapsed_ms();
+    size_t peak = peak_rss_bytes();
+    return {ms, peak_reset && peak > base_rss ? peak - base_rss : 0};
+}
+
+// Run one build in a child process where fork() is available
+template<typename Build>
+StartupSample run_startup_sample(Build& build) {
+#if defined(__linux__)
+    int fds[2];
+    if (pipe(fds) == 0) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            StartupSample sample = measure_startup(build);
+            ssize_t written = write(fds[1], &sample, sizeof(sample));
+            _exit(written == sizeof(sample) ? 0 : 1);
+        }
+        close(fds[1]);
+        StartupSample sample{0, 0};
+        bool ok = false;
+        if (pid > 0) {
+            ok = read(fds[0], &sample, sizeof(sample)) == sizeof(sample);
+            waitpid(pid, nullptr, 0);
+        }
+        close(fds[0]);
+        if (ok) {
+            return sample;
+        }
+    }
+#endif
+    return measure_startup(build);
+}
+
+template<typename Build>
+void benchmark_startup(const std::string& name, size_t n, Build build) {
+    std::vector<double> peaks_mb;
+    auto result = measure(name, n, [&] {
+        StartupSample sample = run_startup_sample(build);
+        peaks_mb.push_back(static_cast<double>(sample.peak_rss_bytes) / 1048576.0);
+        return sample.time_ms;
+    });
+    print_result(result);
+
+    std::sort(peaks_mb.begin(), peaks_mb.end());
+    std::cout << "  peak RSS ";
+    if (peaks_mb.back() > 0) {
+        std::cout << "+" << std::fixed << std::setprecision(1) << quantile(peaks_mb, 0.5) << " MB\n";
+    } else {
+        std::cout << "n/a\n";
+    }
+}
+
+void run_startup_benchmarks(const std::vector<int>& random_data, const std::vector<int>& seq_data) {
+    size_t n = random_data.size();
+    begin_group("Startup (Order " + std::to_string(STARTUP_ORDER) + ")");
+
+    std::vector<int> sorted_data = random_data;
+    std::sort(sorted_data.begin(), sorted_data.end());
+
+    // Serialized image shared by the file-based paths
+    std::filesystem::path image_path = std::filesystem::temp_directory_path() /
+        ("btree_startup_" + std::to_string(n) + ".bin");
+    {
+        std::ofstream out(image_path, std::ios::binary | std::ios::trunc);
+        StartupTree::from_sorted(sorted_data).serialize(out);
+        if (!out) {
+            std::cerr << "Cannot write " << image_path << "; skipping startup suite\n";
+            return;
+        }
+    }
+    std::string image = image_path.string();
+
+    // Text dump of the same keys, one per line
+    std::filesystem::path text_path = std::filesystem::temp_directory_path() /
+        ("btree_startup_" + std::to_string(n) + ".txt");
+    std::string text = text_path.string();
+    print_result(measure("traverse() file", n, [&] {
+        auto tree = StartupTree::from_sorted(sorted_data);
+        std::ofstream out(text, std::ios::trunc);
+        Timer timer;
+        tree.traverse(out);
+        return timer.elapsed_ms();
+    }));
+    print_result(measure("dump_text() file", n, [&] {
+        auto tree = StartupTree::from_sorted(sorted_data);
+        std::ofstream out(text, std::ios::trunc);
+        Timer timer;
+        tree.dump_text(out);
+        out.flush();
+        return timer.elapsed_ms();
+    }));
+
+    benchmark_startup("insert() random", n, [&] {
+        StartupTree tree;
+        for (int key : random_data) {
+            tree.insert(key);
+        }
+        return tree;
+    });
+    benchmark_startup("insert() sorted", n, [&] {
+        StartupTree tree;
+        for (int key : seq_data) {
+            tree.insert(key);
+        }
+        return tree;
+    });
+    benchmark_startup("sort + from_sorted()", n, [&] {
+        std::vector<int> keys = random_data;
+        std::sort(keys.begin(), keys.end());
+        return StartupTree::from_sorted(keys);
+    });
+    benchmark_startup("from_sorted() pre-sorted", n, [&] {
+        return StartupTree::from_sorted(sorted_data);
+    });
+    benchmark_startup("deserialize() file", n, [&] {
+        std::ifstream in(image, std::ios::binary);
+        return StartupTree::deserialize(in);
+    });
+    benchmark_startup("load_text() file", n, [&] {
+        std::ifstream in(text);
+        return StartupTree::load_text(in);
+    });
+#if defined(__linux__)
+    benchmark_startup("mmap + from_serialized()", n, [&] {
+        int fd = open(image.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            throw std::runtime_error("cannot open " + image);
+        }
+        size_t bytes = static_cast<size_t>(st.st_size);
+        void* mapped = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error("cannot map " + image);
+        }
+        StartupTree tree = StartupTree::from_serialized(mapped, bytes);
+        munmap(mapped, bytes);
+        return tree;
+    });
+#endif
+
+    std::error_code ignored;
+    std::filesystem::remove(image_path, ignored);
+    std::filesystem::remove(text_path, ignored);
+}
+
+// ---------------------------------------------------------------------------
+// Concurrent engines: a fixed mix of contains/insert/remove on random keys
+// issued from several threads against each thread-safe wrapper. Each engine
+// is prefilled once; inserts and removes are balanced so its size stays
+// roughly constant across samples. Threads start together and each
+// operation is one call.
+// ---------------------------------------------------------------------------
+
+// BTree behind a reader-writer lock: the baseline for every engine
+template<typename Key, int Order>
+class LockedBTree {
+    BTree<Key, Order> tree_;
+    mutable std::shared_mutex lock_;
+public:
+    void insert(const Key& key) {
+        std::unique_lock<std::shared_mutex> guard(lock_);
+        tree_.insert(key);
+    }
+    void remove(const Key& key) {
+        std::unique_lock<std::shared_mutex> guard(lock_);
+        tree_.remove(key);
+    }
+    bool contains(const Key& key) const {
+        std::shared_lock<std::shared_mutex> guard(lock_);
+        return tree_.search(key);
+    }
+    template<typename Func>
+    void for_each(Func f) const {
+        std::shared_lock<std::shared_mutex> guard(lock_);
+        tree_.for_each(f);
+    }
+};
+
+constexpr int CONCURRENT_ORDER = 64;
+constexpr size_t CONCURRENT_OPS = 400000;  // Per sample, split across threads
+
+// Let engines with deferred writes apply them before timing starts
+template<typename Engine>
+auto settle_engine(Engine& engine, int) -> decltype(engine.flush(), void()) { engine.flush(); }
+template<typename Engine>
+void settle_engine(Engine&, long) {}
+
+enum class ConcurrentOp : uint8_t { Contains, Insert, Remove };
+
+struct ConcurrentMix {
+    std::string name;
+    double read_fraction;  // The rest is split evenly between insert and remove
+};
+
+// Per-thread operation streams over keys in [0, key_range)
+std::vector<std::vector<std::pair<ConcurrentOp, int>>> concurrent_streams(size_t threads, double read_fraction,
+                                                                           int key_range) {
+    std::vector<std::vector<std::pair<ConcurrentOp, int>>> streams(threads);
+    std::mt19937 gen(77);
+    std::uniform_real_distribution<double> kind(0.0, 1.0);
+    std::uniform_int_distribution<int> key(0, key_range - 1);
+    for (auto& stream : streams) {
+        stream.resize(CONCURRENT_OPS / threads);
+        for (auto& op : stream) {
+            double k = kind(gen);
+            op.first = k < read_fraction ? ConcurrentOp::Contains
+                     : k < read_fraction + (1 - read_fraction) / 2 ? ConcurrentOp::Insert
+                     : ConcurrentOp::Remove;
+            op.second = key(gen);
+        }
+    }
+    return streams;
+}
+
+template<typename Engine>
+BenchmarkResult benchmark_concurrent(Engine& engine, const std::string& name,
+                                     const std::vector<std::vector<std::pair<ConcurrentOp, int>>>& streams) {
+    size_t threads = streams.size();
+    return measure(name, streams.front().size() * threads, [&] {
+        std::atomic<size_t> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                size_t hits = 0;
+                for (const auto& op : streams[t]) {
+                    switch (op.first) {
+                        case ConcurrentOp::Contains: hits += engine.contains(op.second); break;
+                        case ConcurrentOp::Insert: engine.insert(op.second); break;
+                        case ConcurrentOp::Remove: engine.remove(op.second); break;
+                    }
+                }
+                do_not_optimize(hits);
+            });
+        }
+        while (ready.load() < threads) {
+            std::this_thread::yield();
+        }
+        Timer timer;
+        go.store(true, std::memory_order_release);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        return timer.elapsed_ms();
+    });
+}
+
+template<typename Engine>
+void run_concurrent_engine(const std::string& label, const std::vector<int>& prefill,
+                           const std::vector<size_t>& thread_counts, const ConcurrentMix& mix, int key_range) {
+    Engine engine;
+    for (int key : prefill) {
+        engine.insert(key);
+    }
+    settle_engine(engine, 0);
+
+    for (size_t threads : thread_counts) {
+        auto streams = concurrent_streams(threads, mix.read_fraction, key_range);
+        print_result(benchmark_concurrent(engine, label + " " + std::to_string(threads) + " thread" +
+                                          (threads > 1 ? "s" : ""), streams));
     }
+}
 
-    print_result(benchmark_set_search(s, random_data));
-    print_result(benchmark_set_find(s, random_data));
-    print_result(benchmark_set_iterate(s));
-    print_result(benchmark_set_remove(random_data));
+// Ingestion while an analytics reader runs full scans back to back: the
+// write stream from one thread, timed with the scanner running
+template<typename Engine>
+void run_writes_during_scans(const std::string& label, const std::vector<int>& prefill, int key_range) {
+    Engine engine;
+    for (int key : prefill) {
+        engine.insert(key);
+    }
+    auto writes = concurrent_streams(1, 0.0, key_range);
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> scans{0};
+    std::thread scanner([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            int64_t sum = 0;
+            engine.for_each([&sum](int key) { sum += key; });
+            do_not_optimize(sum);
+            scans.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    BenchmarkResult result = benchmark_concurrent(engine, label, writes);
+    stop.store(true);
+    scanner.join();
+    print_result(result);
+    std::cout << "  " << scans.load() << " full scans completed" << std::endl;
+}
+
+// Async API: one submitting thread issues a write-heavy stream, either
+// waiting on each future in turn (no batching possible) or queueing it all
+// with callbacks and waiting once, so the executor drains it in batches
+void run_async_benchmarks(const std::vector<int>& prefill, int key_range) {
+    auto stream = concurrent_streams(1, 0.1, key_range).front();
+    BTreeExecutor executor;
+    AsyncBTree<int, CONCURRENT_ORDER> tree(executor);
+    for (int key : prefill) {
+        tree.async_insert(key, [] {});
+    }
+    tree.wait();
+
+    begin_group("Async API (write-heavy, executor " + std::to_string(executor.threads()) + " threads)");
+    LockedBTree<int, CONCURRENT_ORDER> locked;
+    for (int key : prefill) {
+        locked.insert(key);
+    }
+    std::vector<std::vector<std::pair<ConcurrentOp, int>>> single = {stream};
+    print_result(benchmark_concurrent(locked, "mutex BTree, blocking calls", single));
+
+    print_result(measure("AsyncBTree, wait on each future", stream.size(), [&] {
+        Timer timer;
+        size_t hits = 0;
+        for (const auto& op : stream) {
+            switch (op.first) {
+                case ConcurrentOp::Contains: hits += tree.async_find(op.second).get(); break;
+                case ConcurrentOp::Insert: tree.async_insert(op.second).get(); break;
+                case ConcurrentOp::Remove: hits += tree.async_remove(op.second).get(); break;
+            }
+        }
+        do_not_optimize(hits);
+        return timer.elapsed_ms();
+    }));
+
+    print_result(measure("AsyncBTree, batched callbacks", stream.size(), [&] {
+        std::atomic<size_t> hits{0};
+        auto count = [&hits](bool found) { hits.fetch_add(found, std::memory_order_relaxed); };
+        Timer timer;
+        for (const auto& op : stream) {
+            switch (op.first) {
+                case ConcurrentOp::Contains: tree.async_find(op.second, count); break;
+                case ConcurrentOp::Insert: tree.async_insert(op.second, [] {}); break;
+                case ConcurrentOp::Remove: tree.async_remove(op.second, count); break;
+            }
+        }
+        tree.wait();
+        double elapsed = timer.elapsed_ms();
+        do_not_optimize(hits.load());
+        return elapsed;
+    }));
+}
+
+void run_concurrent_benchmarks(const std::vector<int>& random_data) {
+    int key_range = static_cast<int>(random_data.size() * 10);
+    size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::set<size_t> counts = {1, 2, 4, 8, hardware};
+    std::vector<size_t> thread_counts(counts.begin(), counts.end());
+
+    const ConcurrentMix mixes[] = {{"read-mostly, 90% contains", 0.9}, {"write-heavy, 10% contains", 0.1}};
+    for (const ConcurrentMix& mix : mixes) {
+        begin_group("Concurrent (" + mix.name + ")");
+        run_concurrent_engine<LockedBTree<int, CONCURRENT_ORDER>>("mutex BTree", random_data, thread_counts,
+                                                                   mix, key_range);
+        run_concurrent_engine<BufferedBTree<int, CONCURRENT_ORDER>>("buffered BTree", random_data, thread_counts,
+                                                                     mix, key_range);
+        run_concurrent_engine<FlatCombiningBTree<int, CONCURRENT_ORDER>>("flat-combining BTree", random_data,
+                                                                          thread_counts, mix, key_range);
+        run_concurrent_engine<ReplicatedBTree<int, CONCURRENT_ORDER>>("replicated BTree", random_data,
+                                                                       thread_counts, mix, key_range);
+        run_concurrent_engine<BwTree<int, CONCURRENT_ORDER>>("Bw-tree", random_data, thread_counts, mix, key_range);
+    }
+
+    begin_group("Writes during full scans (1 writer, 1 scanner)");
+    run_writes_during_scans<LockedBTree<int, CONCURRENT_ORDER>>("mutex BTree", random_data, key_range);
+    run_writes_during_scans<BwTree<int, CONCURRENT_ORDER>>("Bw-tree", random_data, key_range);
+
+    run_async_benchmarks(random_data, key_range);
+}
+
+// Suites run when no --suite is given, and those run only on request
+const std::set<std::string> default_suites = {"core", "baselines", "strings", "keys", "range", "rebalance"};
+const std::set<std::string> opt_in_suites = {"churn", "startup", "concurrent"};
+
+void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " [options] [sizes...]\n"
+              << "  --cpu N            Pin to CPU N (default: the CPU the run starts on)\n"
+              << "  --no-pin           Do not pin to a CPU\n"
+              << "  --target-error X   Stop sampling once the 95% CI is within X of the mean (default 0.01)\n"
+              << "  --min-samples N    Minimum timed samples per benchmark (default 5)\n"
+              << "  --max-samples N    Maximum timed samples per benchmark (default 50)\n"
+              << "  --max-time-ms X    Wall-clock budget per benchmark (default 3000)\n"
+              << "  --json FILE        Also write results with raw samples to FILE\n"
+              << "  --suite NAME       Run only the named suite (repeatable)\n"
+              << "                     Default suites: core, baselines, strings, keys, range, rebalance\n"
+              << "                     Opt-in suites: churn, startup, concurrent\n"
+              << "  --churn-seconds X  Churn suite duration (default 600)\n"
+              << "  --churn-interval X Churn sampling interval in seconds (default 10)\n"
+              << "  --churn-order N    Churn tree order: 10, 50 or 100 (default 50)\n"
+              << "                     The churn suite uses the first size (default 1000000)\n";
 }
 
 int main(int argc, char* argv[]) {
-    std::vector<size_t> sizes = {10000, 100000, 1000000};
+    std::vector<size_t> sizes;
+    RunnerConfig& config = runner_config();
+    int cpu = current_cpu();
+    std::string json_path;
+    std::set<std::string> suites;
+    ChurnConfig churn;
 
-    // Allow command line override of sizes
-    if (argc > 1) {
-        sizes.clear();
-        for (int i = 1; i < argc; i++) {
-            sizes.push_back(std::stoul(argv[i]));
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--cpu" && has_value) {
+            cpu = std::stoi(argv[++i]);
+        } else if (arg == "--no-pin") {
+            cpu = -1;
+        } else if (arg == "--target-error" && has_value) {
+            config.target_rel_error = std::stod(argv[++i]);
+        } else if (arg == "--min-samples" && has_value) {
+            config.min_samples = std::stoul(argv[++i]);
+        } else if (arg == "--max-samples" && has_value) {
+            config.max_samples = std::stoul(argv[++i]);
+        } else if (arg == "--max-time-ms" && has_value) {
+            config.max_time_ms = std::stod(argv[++i]);
+        } else if (arg == "--suite" && has_value) {
+            std::string suite = argv[++i];
+            if (default_suites.count(suite) == 0 && opt_in_suites.count(suite) == 0) {
+                std::cerr << "Unknown suite: " << suite << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+            suites.insert(suite);
+        } else if (arg == "--churn-seconds" && has_value) {
+            churn.duration_s = std::stod(argv[++i]);
+        } else if (arg == "--churn-interval" && has_value) {
+            churn.interval_s = std::stod(argv[++i]);
+        } else if (arg == "--churn-order" && has_value) {
+            churn.order = std::stoi(argv[++i]);
+        } else if (arg == "--json" && has_value) {
+            json_path = argv[++i];
+        } else if (!arg.empty() && arg[0] != '-') {
+            sizes.push_back(std::stoul(arg));
+        } else {
+            print_usage(argv[0]);
+            return arg == "--help" ? 0 : 1;
         }
     }
+    if (std::count(sizes.begin(), sizes.end(), size_t(0)) > 0) {
+        std::cerr << "Sizes must be positive\n";
+        return 1;
+    }
+    if (!(churn.duration_s > 0) || !(churn.interval_s > 0)) {
+        std::cerr << "--churn-seconds and --churn-interval must be positive\n";
+        return 1;
+    }
+    if (churn.order != 10 && churn.order != 50 && churn.order != 100) {
+        std::cerr << "--churn-order must be 10, 50 or 100\n";
+        return 1;
+    }
+    if (!sizes.empty()) {
+        churn.size = sizes.front();
+    } else {
+        sizes = {10000, 100000, 1000000};
+    }
+    config.max_samples = std::max(config.max_samples, config.min_samples);
+    if (suites.empty()) {
+        suites = default_suites;
+    }
+    auto enabled = [&suites](const char* suite) { return suites.count(suite) > 0; };
 
     std::cout << "BTree Performance Benchmarks\n";
     std::cout << "============================\n";
+    if (cpu >= 0 && pin_to_cpu(cpu)) {
+        std::cout << "Pinned to CPU " << cpu << "\n";
+    } else {
+        cpu = -1;
+        std::cout << "Not pinned to a CPU\n";
+    }
+    std::cout << "Samples: " << config.min_samples << "-" << config.max_samples
+              << ", target error " << config.target_rel_error * 100 << "%, budget "
+              << config.max_time_ms << " ms per benchmark\n";
+    std::cout << "Columns: median time, 95% CI half-width of the mean, ops/sec at the median, samples\n";
 
     for (size_t n : sizes) {
+        if (!enabled("core") && !enabled("baselines") && !enabled("strings") && !enabled("keys") &&
+            !enabled("range") && !enabled("startup") && !enabled("concurrent")) {
+            break;
+        }
         print_header("Size: " + std::to_string(n) + " elements");
+        set_benchmark_size(n);
 
         auto random_data = generate_random(n);
         auto seq_data = generate_sequential(n);
 
-        run_benchmarks_for_order<3>(n, random_data, seq_data);
-        run_benchmarks_for_order<10>(n, random_data, seq_data);
-        run_benchmarks_for_order<50>(n, random_data, seq_data);
-        run_benchmarks_for_order<100>(n, random_data, seq_data);
+        if (enabled("core")) {
+            run_benchmarks_for_order<3>(n, random_data, seq_data);
+            run_benchmarks_for_order<10>(n, random_data, seq_data);
+            run_benchmarks_for_order<50>(n, random_data, seq_data);
+            run_benchmarks_for_order<100>(n, random_data, seq_data);
+            run_batch_insert_benchmarks<50>(random_data);
+            run_insert_mode_benchmarks<50>(random_data);
+            run_insert_mode_benchmarks<10>(random_data);
+            run_node_index_benchmarks(random_data);
+            run_instrumentation_benchmarks<50>(random_data);
+        }
+
+        if (enabled("baselines")) {
+            run_baseline_benchmarks<int32_t>("int32", random_data);
+            run_baseline_benchmarks<int64_t>("int64", generate_random_int64(n));
+            run_baseline_benchmarks<std::string>("string", generate_short_strings(n));
+        }
+
+        if (enabled("strings")) {
+            run_short_string_benchmarks(n);
+        }
+
+        if (enabled("keys")) {
+            run_all_key_type_benchmarks(n);
+        }
 
-        run_set_benchmarks(n, random_data);
+        if (enabled("range")) {
+            run_range_scan_benchmarks(random_data);
+        }
+
+        if (enabled("startup")) {
+            run_startup_benchmarks(random_data, seq_data);
+        }
+
+        if (enabled("concurrent")) {
+            run_concurrent_benchmarks(random_data);
+        }
+    }
+
+    if (enabled("rebalance")) {
+        print_header("Rebalancing primitives (size = fixtures per sample)");
+        run_rebalance_benchmarks<int>("int");
+        run_rebalance_benchmarks<std::string>("string");
+        run_rebalance_benchmarks<FixedString<23>>("FixedString<23>");
+    }
+
+    if (enabled("churn")) {
+        print_header("Steady-state churn (" + std::to_string(static_cast<long>(churn.duration_s)) + " s)");
+        run_churn_benchmark(churn);
     }
 
     std::cout << "\nBenchmarks complete.\n";
+
+    if (!json_path.empty()) {
+        if (!write_results_json(json_path, cpu)) {
+            std::cerr << "Failed to write " << json_path << "\n";
+            return 1;
+        }
+        std::cout << "Results written to " << json_path << "\n";
+    }
     return 0;
 }
@@ -0,0 +1,399 @@
+#include "benchmark_harness.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Compare two btree_benchmark --json outputs.
+//
+// Results are matched by group, name and size (plus occurrence index when a
+// name repeats within a group). For each pair the median speedup is reported
+// together with a two-sided Mann-Whitney U test on the raw samples. A result
+// is a regression when the candidate's median is slower than the baseline's
+// by more than the threshold and the difference is significant at alpha.
+//
+// Exit status: 0 no regressions, 1 regressions found, 2 usage or input error.
+
+// Minimal JSON reader for the benchmark output format
+struct JsonValue {
+    enum class Type { Null, Bool, Number, String, Array, Object } type = Type::Null;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::map<std::string, JsonValue> object;
+
+    const JsonValue& at(const std::string& key) const {
+        auto it = object.find(key);
+        if (type != Type::Object || it == object.end()) {
+            throw std::runtime_error("missing JSON field: " + key);
+        }
+        return it->second;
+    }
+};
+
+class JsonParser {
+    const std::string& text_;
+    size_t pos_ = 0;
+
+    void skip_whitespace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            pos_++;
+        }
+    }
+
+    char peek() {
+        skip_whitespace();
+        if (pos_ >= text_.size()) {
+            throw std::runtime_error("unexpected end of JSON");
+        }
+        return text_[pos_];
+    }
+
+    void expect(char c) {
+        if (peek() != c) {
+            throw std::runtime_error(std::string("expected '") + c + "' at offset " + std::to_string(pos_));
+        }
+        pos_++;
+    }
+
+    bool consume_literal(const char* literal) {
+        size_t len = std::char_traits<char>::length(literal);
+        if (text_.compare(pos_, len, literal) == 0) {
+            pos_ += len;
+            return true;
+        }
+        return false;
+    }
+
+    std::string parse_string() {
+        expect('"');
+        std::string out;
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c == '\\' && pos_ < text_.size()) {
+                char escaped = text_[pos_++];
+                switch (escaped) {
+                    case 'n': out += '\n'; break;
+                    case 't': out += '\t'; break;
+                    case 'r': out += '\r'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'u': pos_ += 4; out += '?'; break;  // Not produced by btree_benchmark
+                    default: out += escaped; break;
+                }
+            } else {
+                out += c;
+            }
+        }
+        expect('"');
+        return out;
+    }
+
+public:
+    explicit JsonParser(const std::string& text) : text_(text) {}
+
+    JsonValue parse() {
+        JsonValue value = parse_value();
+        skip_whitespace();
+        if (pos_ != text_.size()) {
+            throw std::runtime_error("trailing data after JSON value");
+        }
+        return value;
+    }
+
+    JsonValue parse_value() {
+        JsonValue value;
+        char c = peek();
+        if (c == '{') {
+            value.type = JsonValue::Type::Object;
+            pos_++;
+            if (peek() == '}') {
+                pos_++;
+                return value;
+            }
+            while (true) {
+                std::string key = parse_string();
+                expect(':');
+                value.object[key] = parse_value();
+                if (peek() == ',') {
+                    pos_++;
+                    continue;
+                }
+                expect('}');
+                return value;
+            }
+        }
+        if (c == '[') {
+            value.type = JsonValue::Type::Array;
+            pos_++;
+            if (peek() == ']') {
+                pos_++;
+                return value;
+            }
+            while (true) {
+                value.array.push_back(parse_value());
+                if (peek() == ',') {
+                    pos_++;
+                    continue;
+                }
+                expect(']');
+                return value;
+            }
+        }
+        if (c == '"') {
+            value.type = JsonValue::Type::String;
+            value.string = parse_string();
+            return value;
+        }
+        if (consume_literal("true")) {
+            value.type = JsonValue::Type::Bool;
+            value.boolean = true;
+            return value;
+        }
+        if (consume_literal("false")) {
+            value.type = JsonValue::Type::Bool;
+            return value;
+        }
+        if (consume_literal("null")) {
+            return value;
+        }
+
+        size_t consumed = 0;
+        value.type = JsonValue::Type::Number;
+        value.number = std::stod(text_.substr(pos_, 32), &consumed);
+        pos_ += consumed;
+        return value;
+    }
+};
+
+struct Entry {
+    std::string group;
+    std::string name;
+    size_t size;
+    double median_ms;
+    std::vector<double> samples_ms;
+};
+
+std::vector<Entry> load_results(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+    JsonValue root = JsonParser(text).parse();
+
+    std::vector<Entry> entries;
+    for (const JsonValue& r : root.at("results").array) {
+        Entry e;
+        e.group = r.at("group").string;
+        e.name = r.at("name").string;
+        e.size = static_cast<size_t>(r.at("size").number);
+        e.median_ms = r.at("median_ms").number;
+        for (const JsonValue& s : r.at("samples_ms").array) {
+            e.samples_ms.push_back(s.number);
+        }
+        entries.push_back(std::move(e));
+    }
+    return entries;
+}
+
+// Key used to pair results across runs; occurrence disambiguates repeats
+std::string match_key(const Entry& e, size_t occurrence) {
+    return e.group + "\x1f" + e.name + "\x1f" + std::to_string(e.size) + "\x1f" + std::to_string(occurrence);
+}
+
+std::map<std::string, const Entry*> index_results(const std::vector<Entry>& entries) {
+    std::map<std::string, size_t> seen;
+    std::map<std::string, const Entry*> index;
+    for (const Entry& e : entries) {
+        std::string base = match_key(e, 0);
+        index[match_key(e, seen[base]++)] = &e;
+    }
+    return index;
+}
+
+// Two-sided Mann-Whitney U test (normal approximation with tie and
+// continuity corrections). Returns the p-value.
+double mann_whitney_p(const std::vector<double>& a, const std::vector<double>& b) {
+    size_t n1 = a.size();
+    size_t n2 = b.size();
+    if (n1 == 0 || n2 == 0) {
+        return 1.0;
+    }
+
+    std::vector<std::pair<double, int>> all;
+    for (double x : a) all.push_back({x, 0});
+    for (double x : b) all.push_back({x, 1});
+    std::sort(all.begin(), all.end());
+
+    // Average ranks over ties
+    double rank_sum_a = 0;
+    double tie_term = 0;
+    for (size_t i = 0; i < all.size();) {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) {
+            j++;
+        }
+        double avg_rank = (static_cast<double>(i + 1) + static_cast<double>(j)) / 2.0;
+        double ties = static_cast<double>(j - i);
+        tie_term += ties * ties * ties - ties;
+        for (size_t k = i; k < j; k++) {
+            if (all[k].second == 0) {
+                rank_sum_a += avg_rank;
+            }
+        }
+        i = j;
+    }
+
+    double dn1 = static_cast<double>(n1);
+    double dn2 = static_cast<double>(n2);
+    double n = dn1 + dn2;
+    double u = rank_sum_a - dn1 * (dn1 + 1) / 2.0;
+    double mean_u = dn1 * dn2 / 2.0;
+    double var_u = dn1 * dn2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1)));
+    if (var_u <= 0) {
+        return 1.0;
+    }
+    double z = (std::fabs(u - mean_u) - 0.5) / std::sqrt(var_u);
+    if (z < 0) {
+        z = 0;
+    }
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] BASELINE.json CANDIDATE.json\n"
+              << "  --threshold X   Slowdown that counts as a regression, >= 0 (default 0.05)\n"
+              << "  --alpha X       Significance level, between 0 and 1 (default 0.05)\n";
+}
+
+int main(int argc, char* argv[]) {
+    double threshold = 0.05;
+    double alpha = 0.05;
+    std::vector<std::string> paths;
+
+    // Whole-string number; throws std::invalid_argument naming the text
+    auto parse_number = [](const std::string& text) {
+        size_t used = 0;
+        double value = 0;
+        try {
+            value = std::stod(text, &used);
+        } catch (const std::exception&) {
+            used = 0;
+        }
+        if (used == 0 || used != text.size()) {
+            throw std::invalid_argument(text);
+        }
+        return value;
+    };
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--threshold" && has_value) {
+                threshold = parse_number(argv[++i]);
+            } else if (arg == "--alpha" && has_value) {
+                alpha = parse_number(argv[++i]);
+            } else if (!arg.empty() && arg[0] != '-') {
+                paths.push_back(arg);
+            } else {
+                print_usage(argv[0]);
+                return 2;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: invalid number " << e.what() << "\n";
+        print_usage(argv[0]);
+        return 2;
+    }
+    if (!(threshold >= 0) || !(alpha > 0 && alpha < 1)) {
+        std::cerr << "Error: --threshold must be >= 0 and --alpha in (0, 1)\n";
+        print_usage(argv[0]);
+        return 2;
+    }
+    if (paths.size() != 2) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Entry> baseline;
+    std::vector<Entry> candidate;
+    try {
+        baseline = load_results(paths[0]);
+        candidate = load_results(paths[1]);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
+    }
+
+    auto baseline_index = index_results(baseline);
+    auto candidate_index = index_results(candidate);
+
+    size_t regressions = 0;
+    size_t improvements = 0;
+    size_t compared = 0;
+    std::string current_group;
+
+    // Walk the candidate in its own order so output follows the benchmark layout
+    std::map<std::string, size_t> seen;
+    for (const Entry& c : candidate) {
+        std::string base_key = match_key(c, 0);
+        std::string key = match_key(c, seen[base_key]++);
+        auto it = baseline_index.find(key);
+        if (it == baseline_index.end()) {
+            continue;
+        }
+        const Entry& b = *it->second;
+        compared++;
+
+        std::string group = c.group + " @ " + std::to_string(c.size);
+        if (group != current_group) {
+            current_group = group;
+            std::cout << "\n=== " << group << " ===\n";
+        }
+
+        double speedup = c.median_ms > 0 ? b.median_ms / c.median_ms : 0;
+        double p = mann_whitney_p(b.samples_ms, c.samples_ms);
+        bool significant = p < alpha;
+        const char* verdict = "same";
+        if (significant && c.median_ms > b.median_ms * (1 + threshold)) {
+            verdict = "REGRESSION";
+            regressions++;
+        } else if (significant && c.median_ms < b.median_ms) {
+            verdict = "faster";
+            improvements++;
+        } else if (significant && c.median_ms > b.median_ms) {
+            verdict = "slower";
+        }
+
+        std::cout << std::left << std::setw(40) << c.name
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(11) << b.median_ms << " ->"
+                  << std::setw(11) << c.median_ms << " ms"
+                  << std::setprecision(3) << std::setw(8) << speedup << "x"
+                  << "  p=" << std::setprecision(4) << p
+                  << "  " << verdict << "\n";
+    }
+
+    size_t unmatched_baseline = baseline.size() - compared;
+    size_t unmatched_candidate = candidate.size() - compared;
+
+    std::cout << std::defaultfloat;
+    std::cout << "\nCompared " << compared << " results: " << improvements << " faster, "
+              << regressions << " regressions (threshold " << threshold * 100
+              << "%, alpha " << alpha << ")\n";
+    if (unmatched_baseline > 0 || unmatched_candidate > 0) {
+        std::cout << "Unmatched: " << unmatched_baseline << " only in baseline, "
+                  << unmatched_candidate << " only in candidate\n";
+    }
+    return regressions > 0 ? 1 : 0;
+}
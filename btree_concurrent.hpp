@@ -0,0 +1,739 @@
+#pragma once
+
+#include "btree.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+// Thread-safe wrappers around BTree. Each one owns its tree and exposes a
+// small set-like interface (insert, remove, contains) that may be called
+// from any number of threads. Compile with -pthread.
+
+namespace btree_detail {
+
+// Process-wide unique id, so per-thread caches never confuse a destroyed
+// wrapper with a new one allocated at the same address
+inline uint64_t next_instance_id() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Per-thread handles to per-wrapper state (write buffers, publication
+// slots). Each is shared with the wrapper so either side may go away first;
+// when the thread exits, its slots are marked abandoned for the wrapper to
+// reclaim. Slot needs a std::atomic<bool> abandoned member.
+template <typename Slot>
+struct ThreadSlots {
+    std::vector<std::pair<uint64_t, std::shared_ptr<Slot>>> entries;
+
+    void abandon_all() {
+        for (auto& entry : entries) {
+            entry.second->abandoned.store(true, std::memory_order_release);
+        }
+        entries.clear();
+    }
+
+    ~ThreadSlots() { abandon_all(); }
+};
+
+// The calling thread's slot for the wrapper with the given id, created and
+// passed to register_slot on first use
+template <typename Slot, typename Register>
+Slot& thread_slot(uint64_t owner, Register register_slot) {
+    thread_local ThreadSlots<Slot> cache;
+    for (const auto& entry : cache.entries) {
+        if (entry.first == owner) {
+            return *entry.second;
+        }
+    }
+    // Entries for destroyed wrappers are never matched again; dropping them
+    // all at worst registers a second slot for a live wrapper
+    if (cache.entries.size() >= 64) {
+        cache.abandon_all();
+    }
+
+    auto slot = std::make_shared<Slot>();
+    register_slot(slot);
+    cache.entries.push_back({owner, slot});
+    return *slot;
+}
+
+// Parses a sysfs CPU/node list such as "0-3,8-11" (empty on bad input)
+inline std::vector<int> parse_cpu_list(const std::string& text) {
+    std::vector<int> ids;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        std::string range = text.substr(pos, end - pos);
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int id = first; id <= last; id++) {
+                ids.push_back(id);
+            }
+        } catch (const std::exception&) {
+            return {};
+        }
+        pos = end + 1;
+    }
+    return ids;
+}
+
+// CPUs of each online NUMA node, read from sysfs. A single entry with no
+// CPUs means the topology is unknown (or there is only one node).
+inline std::vector<std::vector<int>> numa_node_cpus() {
+    std::vector<std::vector<int>> nodes;
+    std::string line;
+    std::ifstream online("/sys/devices/system/node/online");
+    if (online && std::getline(online, line)) {
+        for (int node : parse_cpu_list(line)) {
+            std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string cpus;
+            if (!cpulist || !std::getline(cpulist, cpus)) {
+                return {{}};
+            }
+            nodes.push_back(parse_cpu_list(cpus));
+        }
+    }
+    if (nodes.size() < 2) {
+        return {{}};
+    }
+    return nodes;
+}
+
+// Runs f on a thread bound to the given CPUs, so memory it touches first is
+// placed on their node. Runs f inline when cpus is empty.
+template <typename Func>
+void run_on_cpus(const std::vector<int>& cpus, Func f) {
+#ifdef __linux__
+    if (!cpus.empty()) {
+        std::thread worker([&] {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            sched_setaffinity(0, sizeof(set), &set);
+            f();
+        });
+        worker.join();
+        return;
+    }
+#endif
+    (void)cpus;
+    f();
+}
+
+// The CPU the calling thread is running on, or -1 if unknown
+inline int current_cpu() {
+#ifdef __linux__
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+}  // namespace btree_detail
+
+// BTree with per-thread write buffers.
+//
+// insert() and remove() only append to the calling thread's own sorted
+// buffer, so writers never contend with each other. Buffers are merged into
+// the tree in one key-ordered batch by a dedicated merger thread (or, with
+// background_merger off, by the writer that fills its buffer). Reads
+// consult the tree and every buffer.
+//
+// Operations from one thread are applied in order. Operations on the same
+// key from different threads are not ordered with each other until they
+// are merged; readers see them in the same order the next merge applies
+// them, so a read never disagrees with the state the merge produces.
+template <typename T, int Order = 64>
+class BufferedBTree {
+public:
+    struct Options {
+        size_t buffer_capacity = 256;     // Pending ops per thread before a merge is requested
+        bool background_merger = true;    // Merge from a dedicated thread
+        std::chrono::milliseconds merge_interval{10};  // Merger wakes at least this often
+    };
+
+private:
+    struct Op {
+        T key;
+        bool insert;
+    };
+
+    // Padded so writers on different threads never share a cache line
+    struct alignas(64) Buffer {
+        std::mutex lock;
+        std::vector<Op> ops;               // Sorted by key; equal keys in arrival order
+        std::atomic<size_t> pending{0};    // ops.size(), readable without the lock
+        std::atomic<bool> abandoned{false};  // Owning thread will not write again
+    };
+
+    BTree<T, Order> tree_;
+    mutable std::shared_mutex tree_lock_;
+    std::vector<std::shared_ptr<Buffer>> buffers_;
+    mutable std::shared_mutex buffers_lock_;
+    const uint64_t id_;
+    const Options options_;
+
+    std::thread merger_;
+    std::mutex merger_lock_;
+    std::condition_variable merger_wake_;
+    bool stopping_ = false;
+    std::atomic<bool> merge_requested_{false};
+    std::atomic<uint64_t> merges_{0};
+
+    static bool key_less(const T& key, const Op& op) { return key < op.key; }
+    static bool op_less(const Op& op, const T& key) { return op.key < key; }
+
+    // The calling thread's buffer, registered on first use
+    Buffer& local_buffer() {
+        return btree_detail::thread_slot<Buffer>(id_, [this](const std::shared_ptr<Buffer>& buffer) {
+            buffer->ops.reserve(options_.buffer_capacity);
+            std::unique_lock<std::shared_mutex> guard(buffers_lock_);
+            buffers_.push_back(buffer);
+        });
+    }
+
+    void buffer_op(const T& key, bool insert) {
+        Buffer& buffer = local_buffer();
+        size_t pending;
+        {
+            std::lock_guard<std::mutex> guard(buffer.lock);
+            auto pos = std::upper_bound(buffer.ops.begin(), buffer.ops.end(), key, key_less);
+            buffer.ops.insert(pos, Op{key, insert});
+            pending = buffer.ops.size();
+            buffer.pending.store(pending, std::memory_order_release);
+        }
+        if (pending < options_.buffer_capacity) {
+            return;
+        }
+        // Past four times capacity the merger is falling behind; merge here
+        if (options_.background_merger && pending < 4 * options_.buffer_capacity) {
+            if (!merge_requested_.exchange(true, std::memory_order_relaxed)) {
+                merger_wake_.notify_one();
+            }
+        } else {
+            flush();
+        }
+    }
+
+    // Requires tree_lock_ held exclusively. Drained buffers of exited
+    // threads are dropped so readers stop visiting them.
+    void merge_locked() {
+        std::vector<Op> batch;
+        {
+            std::unique_lock<std::shared_mutex> list_guard(buffers_lock_);
+            for (auto& buffer : buffers_) {
+                bool abandoned = buffer->abandoned.load(std::memory_order_acquire);
+                if (buffer->pending.load(std::memory_order_acquire) > 0) {
+                    std::vector<Op> ops;
+                    ops.reserve(abandoned ? 0 : options_.buffer_capacity);
+                    {
+                        std::lock_guard<std::mutex> guard(buffer->lock);
+                        ops.swap(buffer->ops);
+                        buffer->pending.store(0, std::memory_order_release);
+                    }
+                    batch.insert(batch.end(), std::make_move_iterator(ops.begin()),
+                                 std::make_move_iterator(ops.end()));
+                }
+                if (abandoned) {
+                    buffer.reset();
+                }
+            }
+            buffers_.erase(std::remove(buffers_.begin(), buffers_.end(), nullptr), buffers_.end());
+        }
+        if (batch.empty()) {
+            return;
+        }
+
+        // One pass in key order; stable, so equal keys keep buffer order
+        // (and within a buffer, arrival order), matching contains()
+        std::stable_sort(batch.begin(), batch.end(),
+                         [](const Op& a, const Op& b) { return a.key < b.key; });
+        for (const Op& op : batch) {
+            if (op.insert) {
+                tree_.insert(op.key);
+            } else {
+                tree_.remove(op.key);
+            }
+        }
+        merges_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void merger_loop() {
+        std::unique_lock<std::mutex> guard(merger_lock_);
+        while (!stopping_) {
+            merger_wake_.wait_for(guard, options_.merge_interval, [this] {
+                return stopping_ || merge_requested_.load(std::memory_order_relaxed);
+            });
+            if (stopping_) {
+                break;
+            }
+            merge_requested_.store(false, std::memory_order_relaxed);
+            guard.unlock();
+            flush();
+            guard.lock();
+        }
+    }
+
+public:
+    BufferedBTree() : BufferedBTree(Options{}) {}
+
+    explicit BufferedBTree(const Options& options)
+        : id_(btree_detail::next_instance_id()), options_(options) {
+        if (options_.background_merger) {
+            merger_ = std::thread([this] { merger_loop(); });
+        }
+    }
+
+    ~BufferedBTree() {
+        if (merger_.joinable()) {
+            {
+                std::lock_guard<std::mutex> guard(merger_lock_);
+                stopping_ = true;
+            }
+            merger_wake_.notify_one();
+            merger_.join();
+        }
+    }
+
+    BufferedBTree(const BufferedBTree&) = delete;
+    BufferedBTree& operator=(const BufferedBTree&) = delete;
+
+    // Buffer an insert; visible to contains() immediately
+    void insert(const T& key) { buffer_op(key, true); }
+
+    // Buffer removal of one occurrence of key (a no-op if none is present
+    // when the removal is applied)
+    void remove(const T& key) { buffer_op(key, false); }
+
+    bool contains(const T& key) const {
+        std::shared_lock<std::shared_mutex> tree_guard(tree_lock_);
+        size_t count = 0;
+        for (auto it = tree_.lower_bound(key); it != tree_.end() && *it == key; ++it) {
+            count++;
+        }
+
+        // Replay pending ops on this key exactly as merge_locked() would
+        std::shared_lock<std::shared_mutex> list_guard(buffers_lock_);
+        for (const auto& buffer : buffers_) {
+            if (buffer->pending.load(std::memory_order_acquire) == 0) {
+                continue;
+            }
+            std::lock_guard<std::mutex> guard(buffer->lock);
+            auto first = std::lower_bound(buffer->ops.begin(), buffer->ops.end(), key, op_less);
+            for (auto it = first; it != buffer->ops.end() && it->key == key; ++it) {
+                if (it->insert) {
+                    count++;
+                } else if (count > 0) {
+                    count--;
+                }
+            }
+        }
+        return count > 0;
+    }
+
+    // Merge every buffer into the tree now
+    void flush() {
+        std::unique_lock<std::shared_mutex> tree_guard(tree_lock_);
+        merge_locked();
+    }
+
+    // Flushes, then returns the number of keys
+    size_t size() {
+        std::unique_lock<std::shared_mutex> tree_guard(tree_lock_);
+        merge_locked();
+        return tree_.size();
+    }
+
+    // Flushes, then applies f to every key in order (writers may keep
+    // buffering meanwhile; their ops are not visited)
+    template <typename Func>
+    void for_each(Func f) {
+        flush();
+        std::shared_lock<std::shared_mutex> tree_guard(tree_lock_);
+        tree_.for_each(f);
+    }
+
+    // Number of non-empty merges performed so far
+    uint64_t merges() const noexcept {
+        return merges_.load(std::memory_order_relaxed);
+    }
+};
+
+// BTree behind a mutex with flat combining.
+//
+// Each thread publishes its request (insert, remove or contains) in its own
+// slot. Whichever thread takes the lock becomes the combiner: it collects
+// every pending request, executes them in one pass sorted by key and posts
+// the results, while the other threads wait on their own slot instead of
+// queueing for the lock. Under contention one lock hand-off serves many
+// operations, and the sorted pass walks neighbouring keys back to back.
+// Every operation is linearizable.
+template <typename T, int Order = 64>
+class FlatCombiningBTree {
+    enum class Kind : uint8_t { Insert, Remove, Contains };
+    enum : uint8_t { Idle, Pending, Done };
+
+    // Written by the owner while Idle, by the combiner while Pending
+    struct alignas(64) Slot {
+        std::atomic<uint8_t> state{Idle};
+        std::atomic<bool> abandoned{false};
+        Kind kind = Kind::Contains;
+        bool result = false;
+        T key{};
+    };
+
+    BTree<T, Order> tree_;
+    std::mutex lock_;
+    std::vector<std::shared_ptr<Slot>> slots_;
+    std::mutex slots_lock_;
+    const uint64_t id_;
+
+    // Combining statistics, written only by the lock holder
+    std::atomic<uint64_t> passes_{0};
+    std::atomic<uint64_t> combined_{0};
+
+    Slot& local_slot() {
+        return btree_detail::thread_slot<Slot>(id_, [this](const std::shared_ptr<Slot>& slot) {
+            std::lock_guard<std::mutex> guard(slots_lock_);
+            slots_.push_back(slot);
+        });
+    }
+
+    // Requires lock_. Repeats while new requests keep arriving (bounded, so
+    // the combiner's own caller is not starved).
+    void combine() {
+        std::vector<Slot*> pending;
+        for (int round = 0; round < 4; round++) {
+            pending.clear();
+            {
+                std::lock_guard<std::mutex> guard(slots_lock_);
+                for (auto& slot : slots_) {
+                    if (slot->state.load(std::memory_order_acquire) == Pending) {
+                        pending.push_back(slot.get());
+                    } else if (slot->abandoned.load(std::memory_order_acquire)) {
+                        slot.reset();
+                    }
+                }
+                slots_.erase(std::remove(slots_.begin(), slots_.end(), nullptr), slots_.end());
+            }
+            if (pending.empty()) {
+                return;
+            }
+
+            std::sort(pending.begin(), pending.end(),
+                      [](const Slot* a, const Slot* b) { return a->key < b->key; });
+            for (Slot* slot : pending) {
+                switch (slot->kind) {
+                    case Kind::Insert: tree_.insert(slot->key); slot->result = true; break;
+                    case Kind::Remove: slot->result = tree_.remove(slot->key); break;
+                    case Kind::Contains: slot->result = tree_.search(slot->key); break;
+                }
+                slot->state.store(Done, std::memory_order_release);
+            }
+            passes_.fetch_add(1, std::memory_order_relaxed);
+            combined_.fetch_add(pending.size(), std::memory_order_relaxed);
+        }
+    }
+
+    bool execute(Kind kind, const T& key) {
+        Slot& slot = local_slot();
+        slot.kind = kind;
+        slot.key = key;
+        slot.state.store(Pending, std::memory_order_release);
+
+        // Wait on our own slot, periodically trying to become the combiner
+        for (unsigned spin = 0;; spin++) {
+            if (slot.state.load(std::memory_order_acquire) == Done) {
+                slot.state.store(Idle, std::memory_order_relaxed);
+                return slot.result;
+            }
+            if (spin % 8 == 0 && lock_.try_lock()) {
+                combine();
+                lock_.unlock();
+                continue;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+public:
+    FlatCombiningBTree() : id_(btree_detail::next_instance_id()) {}
+
+    FlatCombiningBTree(const FlatCombiningBTree&) = delete;
+    FlatCombiningBTree& operator=(const FlatCombiningBTree&) = delete;
+
+    void insert(const T& key) { execute(Kind::Insert, key); }
+
+    // Returns true if an occurrence of key was removed
+    bool remove(const T& key) { return execute(Kind::Remove, key); }
+
+    bool contains(const T& key) { return execute(Kind::Contains, key); }
+
+    size_t size() {
+        std::lock_guard<std::mutex> guard(lock_);
+        return tree_.size();
+    }
+
+    // Applies f to every key in order while holding the lock
+    template <typename Func>
+    void for_each(Func f) {
+        std::lock_guard<std::mutex> guard(lock_);
+        tree_.for_each(f);
+    }
+
+    // Average number of requests executed per combining pass
+    double average_batch() const noexcept {
+        uint64_t passes = passes_.load(std::memory_order_relaxed);
+        return passes == 0 ? 0.0
+                           : static_cast<double>(combined_.load(std::memory_order_relaxed)) /
+                                 static_cast<double>(passes);
+    }
+};
+
+// One BTree replica per NUMA node, kept in step through a shared operation
+// log (node replication).
+//
+// A write appends to the log and is then applied by its own thread to the
+// local replica, after replaying any earlier log entries that replica has
+// not seen yet; every replica applies the log in the same order, so they
+// all reach the same state. Reads are served by the calling thread's local
+// replica once it has caught up with the log, so a remote socket is only
+// touched to append to the log. Each replica is created on a thread bound
+// to its node, and its nodes are allocated by the threads that replay into
+// it, so first-touch placement keeps it in local memory. When the log
+// fills, a replica that lags by more than log_capacity entries is caught up
+// on a thread bound to its own node, and the log is trimmed to the oldest
+// position every replica has applied.
+//
+// Threads map to replicas by the NUMA node of the CPU they run on. On a
+// single-node machine there is one replica, i.e. a reader/writer locked
+// BTree with a log; Options::replicas can force more (threads are then
+// spread by thread id) to exercise the replication anywhere.
+template <typename T, int Order = 64>
+class ReplicatedBTree {
+public:
+    struct Options {
+        size_t replicas = 0;          // 0: one per NUMA node
+        size_t log_capacity = 16384;  // Log entries kept before lagging replicas are caught up
+    };
+
+private:
+    struct LogEntry {
+        T key;
+        bool insert;
+    };
+
+    struct alignas(64) Replica {
+        BTree<T, Order> tree;
+        mutable std::shared_mutex lock;
+        std::atomic<uint64_t> applied{0};  // Log position replayed up to
+        std::vector<int> cpus;             // CPUs of its node (empty: not bound)
+    };
+
+    std::vector<std::unique_ptr<Replica>> replicas_;
+    std::vector<int> cpu_replica_;  // Replica index by CPU, when mapped by node
+
+    std::mutex log_lock_;
+    std::deque<LogEntry> log_;      // Entries from log_base_ on
+    uint64_t log_base_ = 0;
+    std::atomic<uint64_t> log_tail_{0};
+    const size_t log_capacity_;
+
+    Replica& local_replica() const {
+        if (replicas_.size() == 1) {
+            return *replicas_[0];
+        }
+        int cpu = btree_detail::current_cpu();
+        if (cpu >= 0 && static_cast<size_t>(cpu) < cpu_replica_.size() && cpu_replica_[cpu] >= 0) {
+            return *replicas_[cpu_replica_[cpu]];
+        }
+        size_t hash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        return *replicas_[hash % replicas_.size()];
+    }
+
+    // Requires log_lock_. Copies log entries from position `from` on.
+    std::vector<LogEntry> log_suffix(uint64_t from) const {
+        return std::vector<LogEntry>(log_.begin() + static_cast<std::ptrdiff_t>(from - log_base_), log_.end());
+    }
+
+    static void apply(Replica& replica, const std::vector<LogEntry>& entries) {
+        for (const LogEntry& entry : entries) {
+            if (entry.insert) {
+                replica.tree.insert(entry.key);
+            } else {
+                replica.tree.remove(entry.key);
+            }
+        }
+    }
+
+    // Requires the replica's lock held exclusively
+    void catch_up_locked(Replica& replica) {
+        std::vector<LogEntry> entries;
+        uint64_t tail;
+        {
+            std::lock_guard<std::mutex> guard(log_lock_);
+            tail = log_base_ + log_.size();
+            if (replica.applied.load(std::memory_order_relaxed) == tail) {
+                return;
+            }
+            entries = log_suffix(replica.applied.load(std::memory_order_relaxed));
+        }
+        apply(replica, entries);
+        replica.applied.store(tail, std::memory_order_release);
+    }
+
+    // Catches up replicas lagging by more than log_capacity entries, each on
+    // a thread bound to its own node so the nodes it allocates stay local,
+    // then drops the log prefix every replica has applied. Called without
+    // any replica lock held.
+    void trim_log() {
+        for (auto& replica : replicas_) {
+            bool lagging;
+            {
+                std::lock_guard<std::mutex> guard(log_lock_);
+                uint64_t tail = log_base_ + log_.size();
+                lagging = tail - replica->applied.load(std::memory_order_acquire) > log_capacity_;
+            }
+            if (lagging) {
+                btree_detail::run_on_cpus(replica->cpus, [&] {
+                    std::unique_lock<std::shared_mutex> guard(replica->lock);
+                    catch_up_locked(*replica);
+                });
+            }
+        }
+        std::lock_guard<std::mutex> guard(log_lock_);
+        uint64_t oldest = log_base_ + log_.size();
+        for (const auto& replica : replicas_) {
+            oldest = std::min(oldest, replica->applied.load(std::memory_order_acquire));
+        }
+        log_.erase(log_.begin(), log_.begin() + static_cast<std::ptrdiff_t>(oldest - log_base_));
+        log_base_ = oldest;
+    }
+
+    bool write(const T& key, bool insert) {
+        Replica& replica = local_replica();
+        bool result;
+        bool log_full;
+        {
+            std::unique_lock<std::shared_mutex> guard(replica.lock);
+            std::vector<LogEntry> earlier;
+            uint64_t position;
+            {
+                std::lock_guard<std::mutex> log_guard(log_lock_);
+                position = log_base_ + log_.size();
+                earlier = log_suffix(replica.applied.load(std::memory_order_relaxed));
+                log_.push_back(LogEntry{key, insert});
+                log_tail_.store(position + 1, std::memory_order_release);
+                log_full = log_.size() > log_capacity_;
+            }
+            apply(replica, earlier);
+            if (insert) {
+                replica.tree.insert(key);
+                result = true;
+            } else {
+                result = replica.tree.remove(key);
+            }
+            replica.applied.store(position + 1, std::memory_order_release);
+        }
+        if (log_full) {
+            trim_log();
+        }
+        return result;
+    }
+
+    // Runs f on the local replica under a shared lock, after catching it up
+    // with every write completed before the call
+    template <typename Func>
+    auto read(Func f) {
+        Replica& replica = local_replica();
+        uint64_t tail = log_tail_.load(std::memory_order_acquire);
+        {
+            std::shared_lock<std::shared_mutex> guard(replica.lock);
+            if (replica.applied.load(std::memory_order_acquire) >= tail) {
+                return f(replica.tree);
+            }
+        }
+        std::unique_lock<std::shared_mutex> guard(replica.lock);
+        catch_up_locked(replica);
+        return f(replica.tree);
+    }
+
+public:
+    ReplicatedBTree() : ReplicatedBTree(Options{}) {}
+
+    explicit ReplicatedBTree(const Options& options) : log_capacity_(options.log_capacity) {
+        std::vector<std::vector<int>> nodes = btree_detail::numa_node_cpus();
+        size_t count = options.replicas == 0 ? nodes.size() : options.replicas;
+        bool by_node = nodes.size() > 1 && count == nodes.size();
+        for (size_t i = 0; i < count; i++) {
+            const std::vector<int> no_cpus;
+            btree_detail::run_on_cpus(by_node ? nodes[i] : no_cpus,
+                                      [&] { replicas_.push_back(std::make_unique<Replica>()); });
+            if (by_node) {
+                replicas_.back()->cpus = nodes[i];
+                for (int cpu : nodes[i]) {
+                    if (cpu >= static_cast<int>(cpu_replica_.size())) {
+                        cpu_replica_.resize(cpu + 1, -1);
+                    }
+                    cpu_replica_[cpu] = static_cast<int>(i);
+                }
+            }
+        }
+    }
+
+    ReplicatedBTree(const ReplicatedBTree&) = delete;
+    ReplicatedBTree& operator=(const ReplicatedBTree&) = delete;
+
+    void insert(const T& key) { write(key, true); }
+
+    // Returns true if an occurrence of key was removed
+    bool remove(const T& key) { return write(key, false); }
+
+    bool contains(const T& key) {
+        return read([&](const BTree<T, Order>& tree) { return tree.search(key); });
+    }
+
+    size_t size() {
+        return read([](const BTree<T, Order>& tree) { return tree.size(); });
+    }
+
+    // Applies f to every key in order, from the local replica under its lock
+    template <typename Func>
+    void for_each(Func f) {
+        read([&](const BTree<T, Order>& tree) { tree.for_each(f); });
+    }
+
+    // Number of replicas (1 on a single-node machine unless forced)
+    size_t replicas() const noexcept { return replicas_.size(); }
+
+    // Log entries currently retained (trimmed past log_capacity)
+    size_t log_size() {
+        std::lock_guard<std::mutex> guard(log_lock_);
+        return log_.size();
+    }
+};
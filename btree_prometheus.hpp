@@ -0,0 +1,142 @@
+#pragma once
+
+#include "btree.hpp"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+// Renders BTree statistics and BTreeMetrics counters in the Prometheus text
+// exposition format (version 0.0.4), e.g. for the node exporter's textfile
+// collector or any scraper that reads local files.
+
+struct PrometheusOptions {
+    std::string prefix = "btree";  // Metric name prefix
+    std::string labels;            // Extra labels on every sample, e.g. tree="users"
+    bool structure = true;         // Walk the tree for node counts, fill and memory (O(n))
+};
+
+namespace btree_detail {
+
+class PrometheusWriter {
+    std::string& out_;
+    const PrometheusOptions& options_;
+
+public:
+    PrometheusWriter(std::string& out, const PrometheusOptions& options) : out_(out), options_(options) {}
+
+    void header(const std::string& name, const char* type, const char* help) {
+        out_ += "# HELP " + options_.prefix + "_" + name + " " + help + "\n";
+        out_ += "# TYPE " + options_.prefix + "_" + name + " " + type + "\n";
+    }
+
+    // One sample; labels are appended to the configured ones
+    void sample(const std::string& name, const std::string& labels, double value) {
+        std::string all = options_.labels;
+        if (!labels.empty()) {
+            all += (all.empty() ? "" : ",") + labels;
+        }
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.17g", value);
+        out_ += options_.prefix + "_" + name;
+        if (!all.empty()) {
+            out_ += "{" + all + "}";
+        }
+        out_ += " ";
+        out_ += number;
+        out_ += "\n";
+    }
+
+    void single(const std::string& name, const char* type, const char* help, double value) {
+        header(name, type, help);
+        sample(name, "", value);
+    }
+};
+
+}  // namespace btree_detail
+
+// Operation counters, rebalancing counters and latency histograms
+inline std::string prometheus_text(const BTreeMetrics& metrics, const PrometheusOptions& options = {}) {
+    std::string out;
+    btree_detail::PrometheusWriter writer(out, options);
+
+    writer.header("operations_total", "counter", "Operations performed, by kind.");
+    for (int op = 0; op < BTreeMetrics::op_count; op++) {
+        auto kind = static_cast<BTreeMetrics::Op>(op);
+        writer.sample("operations_total", std::string("op=\"") + BTreeMetrics::op_name(kind) + "\"",
+                      static_cast<double>(metrics.operations(kind)));
+    }
+    writer.single("splits_total", "counter", "Node splits.", static_cast<double>(metrics.splits()));
+    writer.single("merges_total", "counter", "Node merges.", static_cast<double>(metrics.merges()));
+    writer.single("borrows_total", "counter", "Key rotations between siblings (remove, and insert under SplitPolicy::Redistribute).",
+                  static_cast<double>(metrics.borrows()));
+
+    writer.header("operation_duration_seconds", "histogram", "Latency of sampled operations, by kind.");
+    for (int op = 0; op < BTreeMetrics::op_count; op++) {
+        auto kind = static_cast<BTreeMetrics::Op>(op);
+        const BTreeMetrics::Histogram& histogram = metrics.latency(kind);
+        std::string op_label = std::string("op=\"") + BTreeMetrics::op_name(kind) + "\"";
+
+        // Buckets are read one by one while writers may record, so clamp
+        // the cumulative counts to stay monotonic and within _count
+        uint64_t count = histogram.count.load(std::memory_order_relaxed);
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b <= BTreeMetrics::bucket_count; b++) {
+            cumulative += histogram.buckets[b].load(std::memory_order_relaxed);
+            char bound[32];
+            if (b < BTreeMetrics::bucket_count) {
+                std::snprintf(bound, sizeof(bound), "%g", static_cast<double>(BTreeMetrics::bucket_bounds_ns[b]) * 1e-9);
+            } else {
+                std::snprintf(bound, sizeof(bound), "+Inf");
+            }
+            uint64_t value = b < BTreeMetrics::bucket_count ? std::min(cumulative, count) : count;
+            writer.sample("operation_duration_seconds_bucket", op_label + ",le=\"" + bound + "\"",
+                          static_cast<double>(value));
+        }
+        writer.sample("operation_duration_seconds_sum", op_label,
+                      static_cast<double>(histogram.sum_ns.load(std::memory_order_relaxed)) * 1e-9);
+        writer.sample("operation_duration_seconds_count", op_label, static_cast<double>(count));
+    }
+    return out;
+}
+
+// Tree gauges (size, height and, with options.structure, node counts, fill
+// and memory) followed by the metrics. The caller must keep writers off the
+// tree while this runs, as for any other read.
+template <typename T, int Order>
+std::string prometheus_text(const BTree<T, Order>& tree, const BTreeMetrics& metrics,
+                            const PrometheusOptions& options = {}) {
+    std::string out;
+    btree_detail::PrometheusWriter writer(out, options);
+    writer.single("keys", "gauge", "Keys stored.", static_cast<double>(tree.size()));
+    writer.single("height", "gauge", "Levels from the root to the leaves.", static_cast<double>(tree.height()));
+    writer.single("order", "gauge", "Maximum children per node.", static_cast<double>(Order));
+    if (options.structure) {
+        auto stats = tree.stats();
+        writer.header("nodes", "gauge", "Nodes, by kind.");
+        writer.sample("nodes", "kind=\"leaf\"", static_cast<double>(stats.leaf_nodes));
+        writer.sample("nodes", "kind=\"internal\"", static_cast<double>(stats.internal_nodes));
+        writer.single("fill_ratio", "gauge", "Fraction of key slots in use.", stats.average_fill());
+        writer.single("memory_bytes", "gauge", "Node memory including reserved capacity.",
+                      static_cast<double>(stats.memory_bytes));
+    }
+    return out + prometheus_text(metrics, options);
+}
+
+// Writes text to path through a temporary file and a rename, so a scraper
+// never reads a partial file. Throws std::runtime_error on failure.
+inline void write_prometheus_file(const std::string& path, const std::string& text) {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file << text;
+        file.flush();
+        if (!file) {
+            throw std::runtime_error("cannot write " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("cannot rename " + temporary + " to " + path);
+    }
+}
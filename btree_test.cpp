@@ -6,10 +6,20 @@
 #include <random>
 #include <algorithm>
 #include <climits>
+#include <cmath>
 #include <set>
+#include <array>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <thread>
 
 // Include the BTree implementation
 #include "btree.hpp"
+#include "btree_concurrent.hpp"
+#include "btree_async.hpp"
+#include "btree_prometheus.hpp"
+#include "bwtree.hpp"
 
 int tests_passed = 0;
 int tests_failed = 0;
@@ -1831,6 +1841,39 @@ TEST(test_remove_case_2c_recursive) {
     ASSERT_EQ(static_cast<size_t>(count), present.size());
 }
 
+// Test: removing separators with duplicates on both sides, odd and even orders
+template <int Order>
+static void check_remove_separators() {
+    BTree<int, Order> tree;
+    std::multiset<int> reference;
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 400; i++) {
+            int key = (i * 37) % 60;
+            tree.insert(key);
+            reference.insert(key);
+        }
+    }
+    // Every key value is duplicated across leaves and separators; draining
+    // value by value removes internal keys through all three cases
+    for (int key = 0; key < 60; key++) {
+        int step = (key * 7) % 60;
+        while (reference.count(step) > 0) {
+            ASSERT_TRUE(tree.remove(step));
+            reference.erase(reference.find(step));
+        }
+        ASSERT_FALSE(tree.remove(step));
+        ASSERT_EQ(tree.to_vector(), std::vector<int>(reference.begin(), reference.end()));
+    }
+    ASSERT_TRUE(tree.empty());
+}
+
+TEST(test_remove_internal_keys) {
+    check_remove_separators<4>();
+    check_remove_separators<5>();
+    check_remove_separators<7>();
+    check_remove_separators<64>();
+}
+
 // Test: Order 4 sustained merge-split cycles (avoids Order 3 known issues)
 TEST(test_order_4_merge_split_cycle) {
     BTree<int, 4> tree;  // Order 4: more reliable than Order 3
@@ -2386,6 +2429,1311 @@ TEST(test_order_5_min_keys_boundary) {
     }
 }
 
+// Test: FixedString ordering matches std::string ordering
+TEST(test_fixed_string_ordering) {
+    std::vector<std::string> words = {"", "a", "ab", "abc", "abd", "b", "ba", "zzzz", "user_42", "user_420"};
+    for (const auto& a : words) {
+        for (const auto& b : words) {
+            FixedString<16> fa(a), fb(b);
+            ASSERT_EQ(fa < fb, a < b);
+            ASSERT_EQ(fa == fb, a == b);
+            ASSERT_EQ(fa > fb, a > b);
+        }
+    }
+    ASSERT_EQ(FixedString<16>("hello").str(), std::string("hello"));
+    ASSERT_EQ(FixedString<16>("hello").size(), 5u);
+    ASSERT_TRUE(FixedString<16>().empty());
+}
+
+// Test: FixedString rejects values longer than its capacity
+TEST(test_fixed_string_capacity) {
+    FixedString<4> exact("abcd");
+    ASSERT_EQ(exact.view(), std::string_view("abcd"));
+
+    bool threw = false;
+    try {
+        FixedString<4> too_long("abcde");
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
+// Test: BTree with FixedString keys against std::set<std::string>
+TEST(test_fixed_string_btree) {
+    BTree<FixedString<23>, node_order_for<FixedString<23>>> tree;
+    std::set<std::string> reference;
+    std::mt19937 gen(7);
+
+    for (int i = 0; i < 2000; i++) {
+        std::string key = "id_" + std::to_string(gen() % 5000);
+        if (reference.insert(key).second) {
+            tree.insert(key);
+        }
+    }
+    ASSERT_EQ(tree.size(), reference.size());
+
+    std::vector<std::string> in_order;
+    for (const auto& key : tree) {
+        in_order.push_back(key.str());
+    }
+    ASSERT_TRUE(std::equal(in_order.begin(), in_order.end(), reference.begin(), reference.end()));
+
+    for (int i = 0; i < 5000; i += 3) {
+        std::string key = "id_" + std::to_string(i);
+        ASSERT_EQ(tree.contains(key), reference.count(key) > 0);
+        if (reference.erase(key) > 0) {
+            ASSERT_TRUE(tree.remove(key));
+        }
+    }
+    ASSERT_EQ(tree.size(), reference.size());
+}
+
+// Test: node_order_for sizes orders from key width
+TEST(test_node_order_for) {
+    ASSERT_EQ(sizeof(FixedString<23>), 24u);
+    ASSERT_EQ((node_order_for<FixedString<23>>), 10);
+    ASSERT_EQ((node_order_for<int>), 64);
+    ASSERT_EQ((node_order_for<int, 1024>), 256);
+    ASSERT_EQ((node_order_for<FixedString<255>>), 4);
+}
+
+// Test: StaticBTree built and queried in a constant expression
+TEST(test_static_btree_constexpr) {
+    constexpr std::array<int, 10> primes = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29};
+    constexpr StaticBTree<int, 10, 4> table(primes);
+    static_assert(table.contains(13), "13 is in the table");
+    static_assert(!table.contains(15), "15 is not in the table");
+    static_assert(*table.lower_bound(14) == 17, "lower_bound(14) is 17");
+    static_assert(*table.upper_bound(17) == 19, "upper_bound(17) is 19");
+    static_assert(table.lower_bound(30) == nullptr, "nothing >= 30");
+    static_assert(table.size() == 10, "size is N");
+
+    constexpr auto deduced = make_static_btree(std::array<int, 3>{-5, 0, 5});
+    static_assert(deduced.contains(-5) && deduced.contains(5), "deduced table");
+
+    constexpr StaticBTree<int, 0> empty_table(std::array<int, 0>{});
+    static_assert(empty_table.empty() && !empty_table.contains(0), "empty table");
+
+    ASSERT_TRUE(table.contains(29));
+    ASSERT_FALSE(table.contains(1));
+}
+
+// Test: StaticBTree lower_bound/upper_bound agree with std algorithms
+TEST(test_static_btree_bounds) {
+    std::array<int, 1000> keys{};
+    std::mt19937 gen(11);
+    for (auto& key : keys) {
+        key = static_cast<int>(gen() % 3000);  // Includes duplicates
+    }
+    std::sort(keys.begin(), keys.end());
+
+    StaticBTree<int, 1000, 5> table(keys);
+    for (int probe = -1; probe <= 3001; probe++) {
+        auto lower = std::lower_bound(keys.begin(), keys.end(), probe);
+        auto upper = std::upper_bound(keys.begin(), keys.end(), probe);
+        const int* table_lower = table.lower_bound(probe);
+        const int* table_upper = table.upper_bound(probe);
+
+        ASSERT_EQ(table_lower == nullptr, lower == keys.end());
+        if (table_lower != nullptr) ASSERT_EQ(*table_lower, *lower);
+        ASSERT_EQ(table_upper == nullptr, upper == keys.end());
+        if (table_upper != nullptr) ASSERT_EQ(*table_upper, *upper);
+        ASSERT_EQ(table.contains(probe), std::binary_search(keys.begin(), keys.end(), probe));
+    }
+}
+
+// Test: StaticBTree rejects unsorted input
+TEST(test_static_btree_unsorted) {
+    bool threw = false;
+    try {
+        StaticBTree<int, 3> table(std::array<int, 3>{3, 1, 2});
+        (void)table;
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
+// Test: stats() node counts, fill and memory
+TEST(test_stats) {
+    BTree<int, 4> tree;
+    auto empty = tree.stats();
+    ASSERT_EQ(empty.nodes, 0u);
+    ASSERT_EQ(empty.average_fill(), 0.0);
+
+    for (int i = 0; i < 1000; i++) {
+        tree.insert(i);
+    }
+    auto stats = tree.stats();
+    ASSERT_EQ(stats.keys, 1000u);
+    ASSERT_EQ(stats.nodes, stats.leaf_nodes + stats.internal_nodes);
+    ASSERT_EQ(stats.height, tree.height());
+    ASSERT_TRUE(stats.internal_nodes > 0);
+    ASSERT_TRUE(stats.average_fill() > 0.0 && stats.average_fill() <= 1.0);
+    ASSERT_TRUE(stats.memory_bytes >= stats.keys * sizeof(int));
+
+    // Every node of an order-4 tree holds 1..3 keys
+    ASSERT_TRUE(stats.nodes >= 1000u / 3 && stats.nodes <= 1000u);
+
+    for (int i = 0; i < 1000; i += 2) {
+        tree.remove(i);
+    }
+    ASSERT_EQ(tree.stats().keys, 500u);
+}
+
+// Test: profiling counters and heatmap under a skewed workload
+TEST(test_heatmap) {
+    using Tree = BTree<int, 8>;
+    Tree tree = Tree::from_sorted([] {
+        std::vector<int> keys(20000);
+        for (int i = 0; i < 20000; i++) keys[i] = i;
+        return keys;
+    }());
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(tree.search(i));  // Not profiled
+    }
+    ASSERT_EQ(tree.heatmap().visits, 0u);
+
+    // Every lookup hits keys below 1000
+    tree.set_profiling(true);
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 1000; i++) {
+            ASSERT_TRUE(tree.search(i));
+        }
+    }
+    tree.insert(500);
+    ASSERT_TRUE(tree.remove(500));
+    tree.set_profiling(false);
+
+    auto heat = tree.heatmap(5);
+    ASSERT_EQ(heat.levels.size(), tree.height());
+    ASSERT_EQ(heat.levels[0].nodes, 1u);
+    ASSERT_EQ(heat.levels[0].visits, 10002u);
+    ASSERT_TRUE(heat.visits > 10002u);
+    ASSERT_EQ(heat.hottest.size(), 5u);
+    ASSERT_TRUE(heat.subtree_count >= 64u);
+    ASSERT_TRUE(heat.hottest[0].first < 1000);
+    ASSERT_TRUE(heat.hottest[0].first <= heat.hottest[0].last);
+    ASSERT_TRUE(heat.hottest[0].visits >= heat.hottest[1].visits);
+    ASSERT_TRUE(heat.top_decile_share > 0.9);
+    ASSERT_TRUE(heat.cold_fraction() > 0.5 && heat.cold_fraction() < 1.0);
+    ASSERT_TRUE(heat.cold_bytes <= heat.memory_bytes);
+
+    std::ostringstream report;
+    tree.heatmap_report(report, 3);
+    ASSERT_TRUE(report.str().find("cold memory") != std::string::npos);
+
+    tree.reset_profile();
+    ASSERT_EQ(tree.heatmap().visits, 0u);
+
+    // Concurrent readers count every root visit exactly once
+    tree.set_profiling(true);
+    std::vector<std::thread> readers;
+    std::atomic<int> hits{0};
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&tree, &hits] {
+            for (int i = 0; i < 2000; i++) {
+                hits += tree.search(i);
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    tree.set_profiling(false);
+    ASSERT_EQ(hits.load(), 8000);
+    ASSERT_EQ(tree.heatmap().levels[0].visits, 8000u);
+}
+
+// Test: OpCost accounting for search, find, insert and remove
+TEST(test_op_cost) {
+    using Tree = BTree<int, 8>;
+    Tree tree;
+    Tree::OpCost build;
+    for (int i = 0; i < 5000; i++) {
+        tree.insert(i, build);
+    }
+    // Each split adds one node; each of the height - 1 root splits also adds a root
+    auto stats = tree.stats();
+    ASSERT_EQ(build.splits, stats.nodes - stats.height);
+    ASSERT_EQ(build.merges + build.borrows, 0u);
+    ASSERT_TRUE(build.nodes_visited >= 4999u);
+
+    Tree::OpCost hit;
+    ASSERT_TRUE(tree.search(4321, hit));
+    ASSERT_TRUE(hit.nodes_visited >= 1 && hit.nodes_visited <= tree.height());
+    ASSERT_TRUE(hit.comparisons > hit.nodes_visited);
+    ASSERT_TRUE(hit.bytes_touched >= hit.comparisons * sizeof(int));
+    ASSERT_TRUE(hit.cache_lines >= hit.nodes_visited);
+    ASSERT_EQ(hit.rebalance_steps(), 0u);
+
+    Tree::OpCost found;
+    auto it = tree.find(4321, found);
+    ASSERT_TRUE(it != tree.end() && *it == 4321);
+    ASSERT_EQ(found.nodes_visited, hit.nodes_visited);
+    ASSERT_EQ(found.comparisons, hit.comparisons);
+
+    // A miss always reaches a leaf; costs accumulate across calls
+    Tree::OpCost miss;
+    ASSERT_FALSE(tree.search(-1, miss));
+    ASSERT_EQ(miss.nodes_visited, tree.height());
+    ASSERT_FALSE(tree.search(5000, miss));
+    ASSERT_EQ(miss.nodes_visited, 2 * tree.height());
+
+    Tree::OpCost removal;
+    for (int i = 0; i < 5000; i++) {
+        ASSERT_TRUE(tree.remove(i, removal));
+    }
+    ASSERT_TRUE(removal.merges > 0 && removal.borrows > 0);
+    ASSERT_EQ(removal.rebalance_steps(), removal.splits + removal.merges + removal.borrows);
+    ASSERT_FALSE(tree.remove(0, removal));
+
+    // Calls without a context leave nothing behind
+    size_t before = removal.nodes_visited;
+    tree.insert(1);
+    ASSERT_EQ(removal.nodes_visited, before);
+    Tree::OpCost after;
+    tree.insert(2, after);
+    ASSERT_EQ(after.nodes_visited, 1u);
+}
+
+// Test: BTreeMetrics counters and the Prometheus text rendering
+TEST(test_metrics_prometheus) {
+    BTreeMetrics metrics(1);  // Time every operation
+    BTree<int, 4> tree;
+    tree.set_metrics(&metrics);
+    for (int i = 0; i < 100; i++) {
+        tree.insert(i);
+    }
+    for (int i = 0; i < 150; i++) {
+        (void)tree.search(i);
+    }
+    ASSERT_TRUE(tree.find(7) != tree.end());
+    for (int i = 0; i < 100; i += 2) {
+        ASSERT_TRUE(tree.remove(i));
+    }
+    ASSERT_EQ(metrics.operations(BTreeMetrics::Insert), 100u);
+    ASSERT_EQ(metrics.operations(BTreeMetrics::Search), 151u);
+    ASSERT_EQ(metrics.operations(BTreeMetrics::Remove), 50u);
+    ASSERT_EQ(metrics.latency(BTreeMetrics::Search).count.load(), 151u);
+    ASSERT_TRUE(metrics.splits() > 0);
+    ASSERT_TRUE(metrics.merges() + metrics.borrows() > 0);
+
+    // Detached trees record nothing
+    tree.set_metrics(nullptr);
+    tree.insert(1000);
+    ASSERT_EQ(metrics.operations(BTreeMetrics::Insert), 100u);
+
+    PrometheusOptions options;
+    options.labels = "tree=\"test\"";
+    std::string text = prometheus_text(tree, metrics, options);
+    ASSERT_TRUE(text.find("# TYPE btree_keys gauge\nbtree_keys{tree=\"test\"} 51\n") != std::string::npos);
+    ASSERT_TRUE(text.find("btree_operations_total{tree=\"test\",op=\"search\"} 151\n") != std::string::npos);
+    ASSERT_TRUE(text.find("btree_nodes{tree=\"test\",kind=\"leaf\"}") != std::string::npos);
+    ASSERT_TRUE(text.find("# TYPE btree_operation_duration_seconds histogram") != std::string::npos);
+    ASSERT_TRUE(text.find("btree_operation_duration_seconds_bucket{tree=\"test\",op=\"insert\",le=\"+Inf\"} 100\n") !=
+                std::string::npos);
+    ASSERT_TRUE(text.find("btree_operation_duration_seconds_count{tree=\"test\",op=\"remove\"} 50\n") !=
+                std::string::npos);
+
+    // Metrics alone, without structure, and written atomically to a file
+    options.structure = false;
+    std::string counters = prometheus_text(metrics, options);
+    ASSERT_TRUE(counters.find("btree_keys") == std::string::npos);
+    ASSERT_TRUE(prometheus_text(tree, metrics, options).find("btree_nodes") == std::string::npos);
+    const std::string path = "btree_test_metrics.prom";
+    write_prometheus_file(path, counters);
+    std::ifstream file(path);
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ASSERT_EQ(contents, counters);
+    std::remove(path.c_str());
+}
+
+// Test: redistributing splits keep contents exact and nodes fuller
+template <int Order>
+static void check_split_policy() {
+    std::mt19937 gen(Order);
+    BTree<int, Order> even;
+    BTree<int, Order> packed;
+    packed.set_split_policy(SplitPolicy::Redistribute);
+    ASSERT_TRUE(packed.split_policy() == SplitPolicy::Redistribute);
+
+    typename BTree<int, Order>::OpCost cost;
+    std::multiset<int> reference;
+    for (int i = 0; i < 20000; i++) {
+        int key = static_cast<int>(gen() % 8000);
+        even.insert(key);
+        packed.insert(key, cost);
+        reference.insert(key);
+    }
+    // Every split (two into three included) adds one node, plus a new
+    // root per level
+    ASSERT_EQ(cost.splits + packed.height(), packed.stats().nodes);
+    ASSERT_TRUE(cost.borrows > 0);
+    ASSERT_TRUE(packed.stats().average_fill() > even.stats().average_fill() + 0.05);
+    ASSERT_TRUE(packed.height() <= even.height());
+
+    for (int i = 0; i < 15000; i++) {
+        int key = static_cast<int>(gen() % 8000);
+        bool expected = reference.count(key) > 0;
+        if (expected) {
+            reference.erase(reference.find(key));
+        }
+        ASSERT_EQ(packed.remove(key), expected);
+        if (i % 3 == 0) {
+            packed.insert(key);
+            reference.insert(key);
+        }
+    }
+    ASSERT_EQ(packed.to_vector(), std::vector<int>(reference.begin(), reference.end()));
+
+    BTree<int, Order> moved(std::move(packed));
+    ASSERT_TRUE(moved.split_policy() == SplitPolicy::Redistribute);
+}
+
+TEST(test_split_policy) {
+    check_split_policy<4>();
+    check_split_policy<5>();
+    check_split_policy<8>();
+    check_split_policy<64>();
+}
+
+// Test: bottom-up inserts against std::multiset, splitting only on demand
+template <int Order>
+static void check_insert_strategy(SplitPolicy policy) {
+    std::mt19937 gen(Order);
+    BTree<int, Order> preemptive;
+    BTree<int, Order> bottom_up;
+    bottom_up.set_insert_strategy(InsertStrategy::BottomUp);
+    bottom_up.set_split_policy(policy);
+    preemptive.set_split_policy(policy);
+    ASSERT_TRUE(bottom_up.insert_strategy() == InsertStrategy::BottomUp);
+
+    std::multiset<int> reference;
+    for (int i = 0; i < 20000; i++) {
+        int key = static_cast<int>(gen() % 8000);
+        preemptive.insert(key);
+        bottom_up.insert(key);
+        reference.insert(key);
+    }
+    ASSERT_EQ(bottom_up.to_vector(), std::vector<int>(reference.begin(), reference.end()));
+    ASSERT_TRUE(bottom_up.stats().nodes <= preemptive.stats().nodes);
+
+    // An insert into a leaf with room splits nothing, whatever lies above
+    typename BTree<int, Order>::OpCost cost;
+    for (int i = 0; i < 15000; i++) {
+        int key = static_cast<int>(gen() % 8000);
+        bool expected = reference.count(key) > 0;
+        if (expected) {
+            reference.erase(reference.find(key));
+        }
+        ASSERT_EQ(bottom_up.remove(key), expected);
+        if (i % 3 == 0) {
+            size_t nodes = bottom_up.stats().nodes;
+            bottom_up.insert(key, cost);
+            ASSERT_TRUE(cost.splits > 0 || bottom_up.stats().nodes == nodes);
+            cost = {};
+            reference.insert(key);
+        }
+    }
+    ASSERT_EQ(bottom_up.to_vector(), std::vector<int>(reference.begin(), reference.end()));
+
+    // Switching back keeps the tree valid
+    bottom_up.set_insert_strategy(InsertStrategy::Preemptive);
+    for (int key = 0; key < 2000; key++) {
+        bottom_up.insert(key);
+        reference.insert(key);
+    }
+    ASSERT_EQ(bottom_up.to_vector(), std::vector<int>(reference.begin(), reference.end()));
+}
+
+TEST(test_insert_strategy) {
+    check_insert_strategy<4>(SplitPolicy::Even);
+    check_insert_strategy<5>(SplitPolicy::Even);
+    check_insert_strategy<8>(SplitPolicy::Redistribute);
+    check_insert_strategy<64>(SplitPolicy::Even);
+}
+
+// Small sampled index (stride 3) so every node shape and rebalancing path
+// runs with samples at Order 12
+template <>
+struct BTreeNodeIndex<int, 12> {
+    static constexpr size_t samples = 3;
+};
+
+// The suggested page-sized setup: two cache lines of samples
+template <>
+struct BTreeNodeIndex<int, 512> {
+    static constexpr size_t samples = 32;
+};
+
+template <int Order>
+static void check_node_index(int key_range) {
+    std::mt19937 gen(static_cast<unsigned>(Order));
+    BTree<int, Order> tree;
+    std::multiset<int> reference;
+    auto matches = [&] {
+        for (int key = -1; key <= key_range; key += 3) {
+            auto lower = tree.lower_bound(key);
+            auto expected = reference.lower_bound(key);
+            if ((lower == tree.end()) != (expected == reference.end()) ||
+                (lower != tree.end() && *lower != *expected)) {
+                return false;
+            }
+            auto upper = tree.upper_bound(key);
+            auto expected_upper = reference.upper_bound(key);
+            if ((upper == tree.end()) != (expected_upper == reference.end()) ||
+                (upper != tree.end() && *upper != *expected_upper)) {
+                return false;
+            }
+            if (tree.search(key) != (reference.count(key) > 0)) {
+                return false;
+            }
+        }
+        return tree.to_vector() == std::vector<int>(reference.begin(), reference.end());
+    };
+
+    for (int round = 0; round < 2; round++) {
+        tree.set_split_policy(round == 0 ? SplitPolicy::Even : SplitPolicy::Redistribute);
+        for (int i = 0; i < 20000; i++) {
+            int key = static_cast<int>(gen() % static_cast<unsigned>(key_range));
+            tree.insert(key);
+            reference.insert(key);
+        }
+        ASSERT_TRUE(matches());
+        for (int i = 0; i < 15000; i++) {
+            int key = static_cast<int>(gen() % static_cast<unsigned>(key_range));
+            bool expected = reference.count(key) > 0;
+            if (expected) {
+                reference.erase(reference.find(key));
+            }
+            ASSERT_EQ(tree.remove(key), expected);
+        }
+        ASSERT_TRUE(matches());
+    }
+    std::vector<int> batch;
+    for (int i = 0; i < 5000; i++) {
+        batch.push_back(static_cast<int>(gen() % static_cast<unsigned>(key_range)));
+        reference.insert(batch.back());
+    }
+    tree.parallel_insert_batch(batch, 2);
+    ASSERT_TRUE(matches());
+    tree = BTree<int, Order>::from_sorted(tree.to_vector());
+    ASSERT_TRUE(matches());
+}
+
+// Test: sampled node index is opt-in and searches match std::multiset
+TEST(test_node_index) {
+    static_assert(BTreeNodeIndex<int, 1024>::samples == 0);
+    static_assert(BTreeNodeIndex<double, 256>::samples == 0);
+    static_assert(BTreeNodeIndex<std::string, 512>::samples == 0);
+    check_node_index<12>(3000);
+    check_node_index<512>(50000);
+
+    // A lookup in a page-sized node reads the samples and one block, not
+    // the ~9 scattered probes of a binary search over 511 keys
+    BTree<int, 512> tree;
+    for (int i = 0; i < 400; i++) {
+        tree.insert(i * 2);
+    }
+    BTree<int, 512>::OpCost cost;
+    ASSERT_TRUE(tree.search(398, cost));
+    ASSERT_EQ(cost.nodes_visited, 1u);
+    ASSERT_TRUE(cost.cache_lines <= 6);
+}
+
+// Test: lower_bound/upper_bound iterators against std::multiset
+TEST(test_lower_upper_bound) {
+    BTree<int, 4> tree;
+    std::multiset<int> reference;
+    std::mt19937 gen(21);
+    for (int i = 0; i < 3000; i++) {
+        int key = static_cast<int>(gen() % 2000);  // Includes duplicates
+        tree.insert(key);
+        reference.insert(key);
+    }
+
+    for (int probe = -5; probe <= 2005; probe++) {
+        auto lower = tree.lower_bound(probe);
+        auto ref_lower = reference.lower_bound(probe);
+        ASSERT_EQ(lower == tree.end(), ref_lower == reference.end());
+        if (ref_lower != reference.end()) ASSERT_EQ(*lower, *ref_lower);
+
+        auto upper = tree.upper_bound(probe);
+        auto ref_upper = reference.upper_bound(probe);
+        ASSERT_EQ(upper == tree.end(), ref_upper == reference.end());
+        if (ref_upper != reference.end()) ASSERT_EQ(*upper, *ref_upper);
+    }
+
+    // Iterating from lower_bound continues in order to the end
+    auto it = tree.lower_bound(1000);
+    auto ref_it = reference.lower_bound(1000);
+    for (; ref_it != reference.end(); ++ref_it, ++it) {
+        ASSERT_TRUE(it != tree.end());
+        ASSERT_EQ(*it, *ref_it);
+    }
+    ASSERT_TRUE(it == tree.end());
+
+    BTree<int> empty;
+    ASSERT_TRUE(empty.lower_bound(1) == empty.end());
+}
+
+// Test: scan() and scan_spans() visit the same keys as iteration
+TEST(test_range_scan) {
+    BTree<int, 5> tree;
+    std::multiset<int> reference;
+    std::mt19937 gen(22);
+    for (int i = 0; i < 2000; i++) {
+        int key = static_cast<int>(gen() % 5000);
+        tree.insert(key);
+        reference.insert(key);
+    }
+
+    for (int start : {-1, 0, 17, 2500, 4990, 6000}) {
+        for (size_t limit : {size_t(0), size_t(1), size_t(10), size_t(100), size_t(5000)}) {
+            std::vector<int> expected;
+            for (auto it = reference.lower_bound(start); it != reference.end() && expected.size() < limit; ++it) {
+                expected.push_back(*it);
+            }
+
+            std::vector<int> visited;
+            size_t count = tree.scan(start, limit, [&visited](int key) { visited.push_back(key); });
+            ASSERT_EQ(count, expected.size());
+            ASSERT_TRUE(visited == expected);
+
+            std::vector<int> spanned;
+            count = tree.scan_spans(start, limit, [&spanned](const int* first, size_t n) {
+                ASSERT_TRUE(n > 0);
+                spanned.insert(spanned.end(), first, first + n);
+            });
+            ASSERT_EQ(count, expected.size());
+            ASSERT_TRUE(spanned == expected);
+        }
+    }
+
+    BTree<int> empty;
+    ASSERT_EQ(empty.scan(0, 10, [](int) {}), 0u);
+}
+
+// Test: from_sorted() builds a valid tree that supports later mutation
+template <int Order>
+void check_from_sorted(size_t n) {
+    std::vector<int> keys(n);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = static_cast<int>(i / 3 * 2);  // Sorted with duplicates
+    }
+    auto tree = BTree<int, Order>::from_sorted(keys);
+    ASSERT_EQ(tree.size(), n);
+    ASSERT_TRUE(tree.to_vector() == keys);
+
+    // Minimal height for the key count
+    size_t capacity = Order - 1;
+    size_t height = n == 0 ? 0 : 1;
+    while (capacity < n) {
+        capacity = capacity * Order + Order - 1;
+        height++;
+    }
+    ASSERT_EQ(tree.height(), height);
+
+    // Node fill invariants hold if inserts and removes keep working
+    std::multiset<int> reference(keys.begin(), keys.end());
+    std::mt19937 gen(static_cast<unsigned>(n));
+    for (int i = 0; i < 300; i++) {
+        int key = static_cast<int>(gen() % (n + 10));
+        if (i % 2 == 0) {
+            tree.insert(key);
+            reference.insert(key);
+        } else {
+            auto it = reference.find(key);
+            ASSERT_EQ(tree.remove(key), it != reference.end());
+            if (it != reference.end()) reference.erase(it);
+        }
+    }
+    ASSERT_TRUE(tree.to_vector() == std::vector<int>(reference.begin(), reference.end()));
+}
+
+TEST(test_from_sorted) {
+    for (size_t n : {0, 1, 2, 3, 4, 5, 9, 10, 24, 25, 26, 100, 124, 125, 1000, 4097}) {
+        check_from_sorted<4>(n);
+        check_from_sorted<5>(n);
+        check_from_sorted<10>(n);
+    }
+
+    std::vector<int> unsorted = {1, 3, 2};
+    bool threw = false;
+    try {
+        auto tree = BTree<int, 4>::from_sorted(unsorted);
+        (void)tree;
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+}
+
+// Test: serialize() round-trips through deserialize() and from_serialized()
+TEST(test_serialize_roundtrip) {
+    BTree<int64_t, 6> tree;
+    std::mt19937 gen(23);
+    for (int i = 0; i < 5000; i++) {
+        tree.insert(static_cast<int64_t>(gen() % 10000) - 5000);
+    }
+
+    std::stringstream stream;
+    tree.serialize(stream);
+    std::string image = stream.str();
+    ASSERT_EQ(image.size(), 32 + tree.size() * sizeof(int64_t));
+
+    // A different order reads the same image
+    auto restored = BTree<int64_t, 16>::deserialize(stream);
+    ASSERT_TRUE(restored.to_vector() == tree.to_vector());
+
+    // In place when aligned, copied when not
+    std::vector<int64_t> aligned(image.size() / sizeof(int64_t) + 1);
+    std::memcpy(aligned.data(), image.data(), image.size());
+    auto attached = BTree<int64_t, 6>::from_serialized(aligned.data(), image.size());
+    ASSERT_TRUE(attached.to_vector() == tree.to_vector());
+    std::string shifted = " " + image;
+    auto copied = BTree<int64_t, 6>::from_serialized(shifted.data() + 1, image.size());
+    ASSERT_TRUE(copied.to_vector() == tree.to_vector());
+
+    using Tree = BTree<int64_t, 6>;
+    std::stringstream empty_stream;
+    Tree().serialize(empty_stream);
+    ASSERT_TRUE(Tree::deserialize(empty_stream).empty());
+}
+
+// Test: malformed serialized input is rejected
+TEST(test_serialize_errors) {
+    BTree<int, 4> tree;
+    for (int i = 0; i < 100; i++) {
+        tree.insert(i);
+    }
+    std::stringstream stream;
+    tree.serialize(stream);
+    std::string image = stream.str();
+
+    auto rejects = [](auto load) {
+        try {
+            load();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    std::string truncated = image.substr(0, image.size() - 1);
+    ASSERT_TRUE(rejects([&] { return BTree<int, 4>::from_serialized(truncated.data(), truncated.size()); }));
+    ASSERT_TRUE(rejects([&] { return BTree<int, 4>::from_serialized(image.data(), 16); }));
+    ASSERT_TRUE(rejects([&] {
+        std::stringstream in(truncated);
+        return BTree<int, 4>::deserialize(in);
+    }));
+    ASSERT_TRUE(rejects([&] { return BTree<int64_t, 4>::from_serialized(image.data(), image.size()); }));
+    std::string bad_magic = image;
+    bad_magic[0] = 'X';
+    ASSERT_TRUE(rejects([&] { return BTree<int, 4>::from_serialized(bad_magic.data(), bad_magic.size()); }));
+
+    // A corrupt count fails as truncated rather than allocating it
+    std::string huge_count = image;
+    uint64_t count = uint64_t(1) << 62;
+    std::memcpy(&huge_count[16], &count, sizeof(count));
+    ASSERT_TRUE(rejects([&] { return BTree<int, 4>::from_serialized(huge_count.data(), huge_count.size()); }));
+    ASSERT_TRUE(rejects([&] {
+        std::stringstream in(huge_count);
+        return BTree<int, 4>::deserialize(in);
+    }));
+
+    std::string unsorted = image;
+    std::swap(unsorted[32], unsorted[36]);
+    ASSERT_TRUE(rejects([&] { return BTree<int, 4>::from_serialized(unsorted.data(), unsorted.size()); }));
+    ASSERT_TRUE(rejects([&] {
+        std::stringstream in(unsorted);
+        return BTree<int, 4>::deserialize(in);
+    }));
+}
+
+// Test: dump_text()/load_text() round trips, unsorted input and errors
+TEST(test_text_dump_load) {
+    BTree<int64_t, 6> numbers;
+    std::mt19937 gen(29);
+    for (int i = 0; i < 5000; i++) {
+        numbers.insert(static_cast<int64_t>(gen()) - (int64_t(1) << 31));
+    }
+    numbers.insert(INT64_MIN);
+    numbers.insert(INT64_MAX);
+    std::stringstream stream;
+    numbers.dump_text(stream);
+    ASSERT_TRUE((BTree<int64_t, 16>::load_text(stream).to_vector() == numbers.to_vector()));
+
+    // Doubles round-trip exactly
+    BTree<double, 8> reals;
+    for (int i = 0; i < 1000; i++) {
+        reals.insert(std::ldexp(static_cast<double>(gen()), -static_cast<int>(gen() % 60)) - 1e6);
+    }
+    std::stringstream real_stream;
+    reals.dump_text(real_stream);
+    ASSERT_TRUE((BTree<double, 8>::load_text(real_stream).to_vector() == reals.to_vector()));
+
+    // Unsorted lines, CRLF endings and no final line break
+    std::stringstream unsorted("30\r\n-7\n30\n12");
+    ASSERT_TRUE((BTree<int, 4>::load_text(unsorted).to_vector() == (std::vector<int>{-7, 12, 30, 30})));
+    std::stringstream empty_stream;
+    ASSERT_TRUE((BTree<int, 4>::load_text(empty_stream).empty()));
+
+    // String keys are whole lines, including empty ones and spaces
+    BTree<std::string, 5> words;
+    for (const char* word : {"", "b c", "a", "b c", " padded "}) {
+        words.insert(word);
+    }
+    std::stringstream word_stream;
+    words.dump_text(word_stream);
+    ASSERT_EQ(word_stream.str(), std::string("\n padded \na\nb c\nb c\n"));
+    ASSERT_TRUE((BTree<std::string, 5>::load_text(word_stream).to_vector() == words.to_vector()));
+
+    auto rejects = [](auto load) {
+        try {
+            load();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    for (const char* bad : {"1\n2x\n3\n", "1\n\n2\n", "99999999999\n", " 4\n"}) {
+        ASSERT_TRUE(rejects([&] {
+            std::stringstream in(bad);
+            return BTree<int, 4>::load_text(in);
+        }));
+    }
+    ASSERT_TRUE(rejects([] {
+        std::stringstream in("short\nmuch too long for eight\n");
+        return BTree<FixedString<8>, 4>::load_text(in);
+    }));
+
+    BTree<std::string, 4> broken;
+    broken.insert("two\nlines");
+    std::stringstream sink;
+    bool thrown = false;
+    try {
+        broken.dump_text(sink);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+}
+
+// Test: parallel_insert_batch() matches sequential inserts
+template <int Order>
+void check_parallel_insert_batch(size_t existing, size_t batch, size_t threads) {
+    std::mt19937 gen(static_cast<unsigned>(existing * 31 + batch + threads));
+    BTree<int, Order> tree;
+    std::multiset<int> reference;
+    for (size_t i = 0; i < existing; i++) {
+        int key = static_cast<int>(gen() % 20000);
+        tree.insert(key);
+        reference.insert(key);
+    }
+
+    // Settings survive the batch, including a bulk build into an empty tree
+    BTreeMetrics metrics;
+    tree.set_metrics(&metrics);
+    tree.set_split_policy(SplitPolicy::Redistribute);
+    tree.set_insert_strategy(InsertStrategy::BottomUp);
+    tree.set_profiling(true);
+
+    std::vector<int> keys(batch);
+    for (auto& key : keys) {
+        key = static_cast<int>(gen() % 20000);  // Overlaps existing keys
+        reference.insert(key);
+    }
+    tree.parallel_insert_batch(keys, threads);
+    ASSERT_TRUE(tree.metrics() == &metrics);
+    ASSERT_TRUE(tree.split_policy() == SplitPolicy::Redistribute);
+    ASSERT_TRUE(tree.insert_strategy() == InsertStrategy::BottomUp);
+    ASSERT_TRUE(tree.profiling());
+    ASSERT_EQ(tree.size(), reference.size());
+    ASSERT_TRUE(tree.to_vector() == std::vector<int>(reference.begin(), reference.end()));
+
+    // Structure stays valid under further mutation
+    for (int i = 0; i < 500; i++) {
+        int key = static_cast<int>(gen() % 20000);
+        auto it = reference.find(key);
+        ASSERT_EQ(tree.remove(key), it != reference.end());
+        if (it != reference.end()) reference.erase(it);
+        tree.insert(key + 1);
+        reference.insert(key + 1);
+    }
+    ASSERT_TRUE(tree.to_vector() == std::vector<int>(reference.begin(), reference.end()));
+}
+
+TEST(test_parallel_insert_batch) {
+    for (size_t threads : {1, 2, 4, 7}) {
+        check_parallel_insert_batch<4>(0, 1000, threads);
+        check_parallel_insert_batch<4>(2, 1000, threads);
+        check_parallel_insert_batch<4>(5000, 20000, threads);
+        check_parallel_insert_batch<5>(3000, 100, threads);
+        check_parallel_insert_batch<10>(10000, 10000, threads);
+        check_parallel_insert_batch<64>(50000, 5000, threads);
+    }
+
+    // Default thread count and empty batch
+    BTree<int, 8> tree;
+    for (int i = 0; i < 1000; i++) tree.insert(i);
+    tree.parallel_insert_batch({});
+    tree.parallel_insert_batch({-1, 500, 2000});
+    ASSERT_EQ(tree.size(), 1003u);
+    ASSERT_EQ(tree.min(), -1);
+    ASSERT_EQ(tree.max(), 2000);
+}
+
+// Test: BufferedBTree reads see buffered writes and merges apply them
+TEST(test_buffered_btree_basic) {
+    for (bool background : {false, true}) {
+        BufferedBTree<int, 8>::Options options;
+        options.buffer_capacity = 16;
+        options.background_merger = background;
+        BufferedBTree<int, 8> tree(options);
+
+        for (int i = 0; i < 1000; i++) {
+            tree.insert(i);
+            ASSERT_TRUE(tree.contains(i));
+        }
+        tree.insert(5);  // Duplicate
+        for (int i = 0; i < 1000; i += 2) {
+            tree.remove(i);
+        }
+        tree.remove(5000);  // Absent: no-op
+
+        tree.remove(5);
+        ASSERT_TRUE(tree.contains(5));  // One copy remains
+        tree.remove(5);
+        ASSERT_FALSE(tree.contains(5));
+        ASSERT_FALSE(tree.contains(4));
+        ASSERT_TRUE(tree.contains(7));
+
+        ASSERT_EQ(tree.size(), 499u);
+        ASSERT_TRUE(tree.merges() > 0);
+        std::vector<int> keys;
+        tree.for_each([&keys](int key) { keys.push_back(key); });
+        ASSERT_EQ(keys.size(), 499u);
+        ASSERT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+        ASSERT_EQ(keys.front(), 1);
+    }
+}
+
+// Test: BufferedBTree with concurrent writers and readers
+TEST(test_buffered_btree_threads) {
+    BufferedBTree<int, 16>::Options options;
+    options.buffer_capacity = 64;
+    options.merge_interval = std::chrono::milliseconds(1);
+    BufferedBTree<int, 16> tree(options);
+
+    const int threads = 4;
+    const int per_thread = 5000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&tree, t] {
+            // Insert a disjoint range, then remove its odd keys
+            for (int i = 0; i < per_thread; i++) {
+                tree.insert(t * per_thread + i);
+            }
+            for (int i = 1; i < per_thread; i += 2) {
+                tree.remove(t * per_thread + i);
+            }
+        });
+    }
+    std::atomic<bool> reader_ok{true};
+    std::thread reader([&tree, &reader_ok] {
+        // Even keys are never removed, so once seen they must stay visible
+        std::vector<bool> seen(threads * per_thread, false);
+        for (int round = 0; round < 20; round++) {
+            for (int key = 0; key < threads * per_thread; key += 50) {
+                bool present = tree.contains(key);
+                if (seen[key] && !present) {
+                    reader_ok = false;
+                }
+                seen[key] = seen[key] || present;
+            }
+        }
+    });
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    reader.join();
+    ASSERT_TRUE(reader_ok);
+
+    ASSERT_EQ(tree.size(), static_cast<size_t>(threads * per_thread / 2));
+    for (int t = 0; t < threads; t++) {
+        ASSERT_TRUE(tree.contains(t * per_thread));
+        ASSERT_FALSE(tree.contains(t * per_thread + 1));
+    }
+}
+
+// Test: FlatCombiningBTree results under concurrent inserts and removes
+TEST(test_flat_combining_btree) {
+    FlatCombiningBTree<int, 8> tree;
+    tree.insert(1);
+    tree.insert(1);
+    ASSERT_TRUE(tree.contains(1));
+    ASSERT_TRUE(tree.remove(1));
+    ASSERT_TRUE(tree.remove(1));
+    ASSERT_FALSE(tree.remove(1));
+    ASSERT_FALSE(tree.contains(1));
+
+    // Every thread inserts all keys; removes then race, and each inserted
+    // copy must be removed exactly once
+    const int threads = 4;
+    const int keys = 2000;
+    std::vector<std::thread> workers;
+    std::vector<int> removed(threads, 0);
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&tree, t, keys] {
+            for (int i = 0; i < keys; i++) {
+                tree.insert((i * 7 + t) % keys);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    ASSERT_EQ(tree.size(), static_cast<size_t>(threads * keys));
+
+    workers.clear();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&tree, &removed, t, keys] {
+            for (int round = 0; round < threads + 1; round++) {
+                for (int i = 0; i < keys; i++) {
+                    removed[t] += tree.remove(i);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    int total = 0;
+    for (int r : removed) total += r;
+    ASSERT_EQ(total, threads * keys);
+    ASSERT_EQ(tree.size(), 0u);
+    ASSERT_TRUE(tree.average_batch() >= 1.0);
+}
+
+// Test: ReplicatedBTree, default placement and forced replicas with a small log
+TEST(test_replicated_btree) {
+    ReplicatedBTree<int, 8> single;
+    ASSERT_TRUE(single.replicas() >= 1);
+    single.insert(3);
+    single.insert(3);
+    ASSERT_TRUE(single.contains(3));
+    ASSERT_TRUE(single.remove(3));
+    ASSERT_TRUE(single.contains(3));
+    ASSERT_TRUE(single.remove(3));
+    ASSERT_FALSE(single.remove(3));
+
+    ReplicatedBTree<int, 8>::Options options;
+    options.replicas = 3;
+    options.log_capacity = 64;
+    ReplicatedBTree<int, 8> tree(options);
+    ASSERT_EQ(tree.replicas(), 3u);
+
+    // Writers land on different replicas; every replica must converge and
+    // each inserted copy must be removed exactly once
+    const int threads = 4;
+    const int keys = 1000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&tree, t, keys] {
+            for (int i = 0; i < keys; i++) {
+                tree.insert((i * 7 + t) % keys);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    ASSERT_TRUE(tree.log_size() <= 64u + threads);
+
+    std::vector<size_t> sizes(threads);
+    workers.clear();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&tree, &sizes, t] { sizes[t] = tree.size(); });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (size_t size : sizes) {
+        ASSERT_EQ(size, static_cast<size_t>(threads * keys));
+    }
+
+    std::vector<int> removed(threads, 0);
+    workers.clear();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&tree, &removed, t, keys] {
+            for (int round = 0; round < threads + 1; round++) {
+                for (int i = 0; i < keys; i++) {
+                    removed[t] += tree.remove(i);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    int total = 0;
+    for (int r : removed) total += r;
+    ASSERT_EQ(total, threads * keys);
+    ASSERT_EQ(tree.size(), 0u);
+}
+
+// Test: AsyncBTree futures and callbacks, applied in submission order
+TEST(test_async_btree) {
+    BTreeExecutor::Options options;
+    options.threads = 2;
+    options.max_batch = 16;
+    BTreeExecutor executor(options);
+    AsyncBTree<int, 8> tree(executor);
+
+    std::future<void> inserted = tree.async_insert(5);
+    std::future<bool> found = tree.async_find(5);
+    std::future<bool> removed = tree.async_remove(5);
+    std::future<bool> gone = tree.async_find(5);
+    inserted.get();
+    ASSERT_TRUE(found.get());
+    ASSERT_TRUE(removed.get());
+    ASSERT_FALSE(gone.get());
+
+    // Submitters on several threads queue callbacks without waiting
+    const int threads = 4;
+    const int keys = 500;
+    std::atomic<int> completed{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&tree, &completed, t, keys] {
+            for (int i = 0; i < keys; i++) {
+                tree.async_insert(i * threads + t, [&completed] { completed++; });
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    tree.wait();
+    ASSERT_EQ(completed.load(), threads * keys);
+    ASSERT_EQ(tree.size(), static_cast<size_t>(threads * keys));
+
+    std::vector<int> range = tree.async_range(100, 5).get();
+    ASSERT_EQ(range, (std::vector<int>{100, 101, 102, 103, 104}));
+
+    std::atomic<int> hits{0};
+    for (int i = 0; i < threads * keys; i += 2) {
+        tree.async_remove(i, [&hits](bool ok) { hits += ok; });
+    }
+    std::vector<int> last;
+    tree.async_range(0, 4, [&last](std::vector<int> keys) { last = std::move(keys); });
+    tree.wait();
+    ASSERT_EQ(hits.load(), threads * keys / 2);
+    ASSERT_EQ(last, (std::vector<int>{1, 3, 5, 7}));
+
+    // Callbacks run outside the tree's lock and may call back into it
+    std::atomic<size_t> seen{0};
+    tree.async_insert(-1, [&tree, &seen] { seen = tree.size(); });
+    tree.wait();
+    ASSERT_EQ(seen.load(), static_cast<size_t>(threads * keys / 2 + 1));
+}
+
+namespace {
+// Key whose comparisons throw when either side is negative
+struct PickyKey {
+    int value;
+    static void check(int a, int b) {
+        if (a < 0 || b < 0) {
+            throw std::runtime_error("negative key");
+        }
+    }
+    bool operator<(const PickyKey& other) const { check(value, other.value); return value < other.value; }
+    bool operator>(const PickyKey& other) const { return other < *this; }
+    bool operator==(const PickyKey& other) const { check(value, other.value); return value == other.value; }
+};
+}  // namespace
+
+// Test: AsyncBTree failures reach futures, fail handlers or wait() without
+// stalling the queue
+TEST(test_async_btree_failures) {
+    BTreeExecutor executor(BTreeExecutor::Options{1, 8});
+    AsyncBTree<PickyKey, 4> tree(executor);
+    tree.async_insert(PickyKey{1}).get();
+
+    bool threw = false;
+    try {
+        tree.async_insert(PickyKey{-1}).get();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+
+    std::atomic<int> failed{0};
+    std::atomic<int> done{0};
+    tree.async_remove(PickyKey{-2}, [&done](bool) { done++; }, [&failed](std::exception_ptr) { failed++; });
+    tree.async_insert(PickyKey{-3}, [&done] { done++; });
+    tree.async_insert(PickyKey{2}, [&done] { done++; });
+    threw = false;
+    try {
+        tree.wait();
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+    ASSERT_EQ(failed.load(), 1);
+    ASSERT_EQ(done.load(), 1);
+
+    // A throwing callback is reported once, and later operations still run
+    tree.async_insert(PickyKey{3}, [] { throw std::logic_error("callback"); });
+    threw = false;
+    try {
+        tree.wait();
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    ASSERT_TRUE(threw);
+    tree.wait();
+    ASSERT_EQ(tree.size(), 3u);
+}
+
+// Test: BwTree against std::set with splits and consolidations
+TEST(test_bwtree_single_thread) {
+    BwTree<int, 4> tree;
+    std::set<int> reference;
+    std::mt19937 gen(24);
+    for (int i = 0; i < 20000; i++) {
+        int key = static_cast<int>(gen() % 3000);
+        switch (gen() % 3) {
+            case 0: ASSERT_EQ(tree.insert(key), reference.insert(key).second); break;
+            case 1: ASSERT_EQ(tree.remove(key), reference.erase(key) > 0); break;
+            default: ASSERT_EQ(tree.contains(key), reference.count(key) > 0); break;
+        }
+    }
+    ASSERT_EQ(tree.size(), reference.size());
+    ASSERT_TRUE(tree.height() > 2);
+
+    std::vector<int> keys;
+    tree.for_each([&keys](int key) { keys.push_back(key); });
+    ASSERT_TRUE(keys == std::vector<int>(reference.begin(), reference.end()));
+}
+
+// Test: BwTree with concurrent inserts, removes and lookups
+TEST(test_bwtree_threads) {
+    BwTree<int, 8> tree;
+    const int threads = 4;
+    const int per_thread = 20000;
+
+    // Interleaved key ranges, so threads split the same pages
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&tree, t] {
+            for (int i = 0; i < per_thread; i++) {
+                tree.insert(i * threads + t);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    ASSERT_EQ(tree.size(), static_cast<size_t>(threads * per_thread));
+    for (int key = 0; key < threads * per_thread; key++) {
+        ASSERT_TRUE(tree.contains(key));
+    }
+
+    // Racing removes of the same keys succeed exactly once per key, while
+    // keys that are never removed stay visible
+    std::vector<int> removed(threads, 0);
+    std::atomic<bool> lookups_ok{true};
+    workers.clear();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&tree, &removed, &lookups_ok, t] {
+            for (int key = t % 2; key < threads * per_thread; key += 2) {
+                if (key % 4 == 1) {
+                    lookups_ok = lookups_ok && tree.contains(key);
+                } else {
+                    removed[t] += tree.remove(key);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    ASSERT_TRUE(lookups_ok);
+    int total = 0;
+    for (int r : removed) total += r;
+    ASSERT_EQ(total, threads * per_thread * 3 / 4);
+
+    std::vector<int> keys;
+    tree.for_each([&keys](int key) { keys.push_back(key); });
+    ASSERT_EQ(keys.size(), static_cast<size_t>(threads * per_thread / 4));
+    for (int key : keys) {
+        ASSERT_EQ(key % 4, 1);
+    }
+}
+
+// Test: BwTree scans, bounded and concurrent with splits and removes
+TEST(test_bwtree_scan) {
+    BwTree<int, 8> tree;
+    for (int i = 0; i < 1000; i += 2) {
+        tree.insert(i);
+    }
+    std::vector<int> keys;
+    ASSERT_EQ(tree.scan(101, 5, [&keys](int key) { keys.push_back(key); }), 5u);
+    ASSERT_EQ(keys, (std::vector<int>{102, 104, 106, 108, 110}));
+    keys.clear();
+    ASSERT_EQ(tree.scan(990, 100, [&keys](int key) { keys.push_back(key); }), 5u);
+    ASSERT_EQ(tree.scan(999, 100, [](int) {}), 0u);
+
+    // Stable keys (multiples of 4) are never touched; writers insert and
+    // remove the others, splitting leaves under the scanners. Every scan
+    // must be strictly increasing and see every stable key exactly once.
+    const int range = 20000;
+    for (int key = 0; key < range; key += 4) {
+        tree.insert(key);
+    }
+    std::atomic<bool> stop{false};
+    std::atomic<bool> scans_ok{true};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 2; t++) {
+        workers.emplace_back([&tree, t, range] {
+            for (int round = 0; round < 3; round++) {
+                for (int key = 1 + t; key < range; key += 4) {
+                    tree.insert(key);
+                    tree.insert(key + 1);
+                }
+                for (int key = 1 + t; key < range; key += 4) {
+                    tree.remove(key);
+                }
+            }
+        });
+    }
+    workers.emplace_back([&tree, &stop, &scans_ok, range] {
+        while (!stop.load()) {
+            int previous = -1;
+            int stable = 0;
+            tree.scan(0, SIZE_MAX, [&](int key) {
+                if (key <= previous) {
+                    scans_ok = false;
+                }
+                stable += key % 4 == 0 && key < range;
+                previous = key;
+            });
+            if (stable != range / 4) {
+                scans_ok = false;
+            }
+        }
+    });
+    for (int t = 0; t < 2; t++) {
+        workers[t].join();
+    }
+    stop = true;
+    workers[2].join();
+    ASSERT_TRUE(scans_ok);
+}
+
 int main() {
     std::cout << "=== BTree Unit Tests ===" << std::endl << std::endl;
 
@@ -2512,6 +3860,7 @@ int main() {
     // Edge condition tests - Tier 1: Critical
     RUN_TEST(test_root_collapse_internal);
     RUN_TEST(test_remove_case_2c_recursive);
+    RUN_TEST(test_remove_internal_keys);
     RUN_TEST(test_order_4_merge_split_cycle);
     RUN_TEST(test_borrow_from_right_sibling);
     RUN_TEST(test_rightmost_child_merge_left);
@@ -2537,6 +3886,52 @@ int main() {
     RUN_TEST(test_height_stable_after_removes);
     RUN_TEST(test_order_5_min_keys_boundary);
 
+    // Fixed-capacity string keys
+    RUN_TEST(test_fixed_string_ordering);
+    RUN_TEST(test_fixed_string_capacity);
+    RUN_TEST(test_fixed_string_btree);
+    RUN_TEST(test_node_order_for);
+
+    // Compile-time static trees
+    RUN_TEST(test_static_btree_constexpr);
+    RUN_TEST(test_static_btree_bounds);
+    RUN_TEST(test_static_btree_unsorted);
+
+    // Tree statistics
+    RUN_TEST(test_stats);
+    RUN_TEST(test_heatmap);
+    RUN_TEST(test_op_cost);
+    RUN_TEST(test_metrics_prometheus);
+    RUN_TEST(test_split_policy);
+    RUN_TEST(test_insert_strategy);
+    RUN_TEST(test_node_index);
+
+    // Range queries
+    RUN_TEST(test_lower_upper_bound);
+    RUN_TEST(test_range_scan);
+
+    // Bulk construction and serialization
+    RUN_TEST(test_from_sorted);
+    RUN_TEST(test_serialize_roundtrip);
+    RUN_TEST(test_serialize_errors);
+    RUN_TEST(test_text_dump_load);
+
+    // Parallel batch insert
+    RUN_TEST(test_parallel_insert_batch);
+
+    // Concurrent wrappers
+    RUN_TEST(test_buffered_btree_basic);
+    RUN_TEST(test_buffered_btree_threads);
+    RUN_TEST(test_flat_combining_btree);
+    RUN_TEST(test_replicated_btree);
+    RUN_TEST(test_async_btree);
+    RUN_TEST(test_async_btree_failures);
+
+    // Bw-tree
+    RUN_TEST(test_bwtree_single_thread);
+    RUN_TEST(test_bwtree_threads);
+    RUN_TEST(test_bwtree_scan);
+
     std::cout << std::endl;
     std::cout << "=== Results ===" << std::endl;
     std::cout << "Passed: " << tests_passed << std::endl;
@@ -0,0 +1,630 @@
+#pragma once
+
+#include "btree_concurrent.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace btree_detail {
+
+// Epoch-based reclamation. Threads announce the epoch they entered in while
+// they may hold pointers into a shared structure; memory retired at epoch r
+// is freed once every thread inside a critical section entered after r.
+class EpochManager {
+    struct alignas(64) Participant {
+        std::atomic<uint64_t> epoch{0};  // 0 = not inside a critical section
+        std::atomic<bool> abandoned{false};
+        uint32_t depth = 0;              // Nesting, touched only by the owner
+    };
+
+    struct Retired {
+        void* ptr;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    static constexpr size_t reclaim_batch = 64;
+
+    std::atomic<uint64_t> global_{1};
+    std::vector<std::shared_ptr<Participant>> participants_;
+    std::mutex participants_lock_;
+    std::vector<Retired> retired_;
+    std::mutex retired_lock_;
+    const uint64_t id_;
+
+    Participant& local() {
+        return thread_slot<Participant>(id_, [this](const std::shared_ptr<Participant>& p) {
+            std::lock_guard<std::mutex> guard(participants_lock_);
+            participants_.push_back(p);
+        });
+    }
+
+    // Oldest epoch still inside a critical section (UINT64_MAX if none)
+    uint64_t min_active() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t min_epoch = UINT64_MAX;
+        std::lock_guard<std::mutex> guard(participants_lock_);
+        for (auto& p : participants_) {
+            uint64_t e = p->epoch.load(std::memory_order_acquire);
+            if (e != 0) {
+                min_epoch = std::min(min_epoch, e);
+            } else if (p->abandoned.load(std::memory_order_acquire)) {
+                p.reset();
+            }
+        }
+        participants_.erase(std::remove(participants_.begin(), participants_.end(), nullptr), participants_.end());
+        return min_epoch;
+    }
+
+    void reclaim() {
+        global_.fetch_add(1, std::memory_order_acq_rel);
+        uint64_t safe_before = min_active();
+
+        std::vector<Retired> ready;
+        {
+            std::lock_guard<std::mutex> guard(retired_lock_);
+            auto keep = std::partition(retired_.begin(), retired_.end(),
+                                       [safe_before](const Retired& r) { return r.epoch >= safe_before; });
+            ready.assign(keep, retired_.end());
+            retired_.erase(keep, retired_.end());
+        }
+        for (const Retired& r : ready) {
+            r.deleter(r.ptr);
+        }
+    }
+
+public:
+    EpochManager() : id_(next_instance_id()) {}
+
+    ~EpochManager() {
+        for (const Retired& r : retired_) {
+            r.deleter(r.ptr);
+        }
+    }
+
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+
+    // RAII critical section; nested guards on one thread are free
+    class Guard {
+        Participant* participant_;
+    public:
+        Guard(Participant& p, uint64_t epoch) : participant_(&p) {
+            if (p.depth++ == 0) {
+                p.epoch.store(epoch, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+        ~Guard() {
+            if (--participant_->depth == 0) {
+                participant_->epoch.store(0, std::memory_order_release);
+            }
+        }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    Guard enter() {
+        return Guard(local(), global_.load(std::memory_order_acquire));
+    }
+
+    // Free ptr once no critical section that could still see it remains.
+    // The caller must already have unlinked it.
+    void retire(void* ptr, void (*deleter)(void*)) {
+        size_t pending;
+        {
+            std::lock_guard<std::mutex> guard(retired_lock_);
+            retired_.push_back({ptr, deleter, global_.load(std::memory_order_acquire)});
+            pending = retired_.size();
+        }
+        if (pending % reclaim_batch == 0) {
+            reclaim();
+        }
+    }
+};
+
+}  // namespace btree_detail
+
+// Latch-free B+-tree in the style of the Bw-tree.
+//
+// Nodes are addressed by page id through a mapping table. An update never
+// modifies a node: it prepends a delta record (insert, delete, split or
+// index entry) to the page's chain and installs it with one compare-and-
+// swap on the mapping table slot. Long chains are consolidated into a fresh
+// base node the same way, and replaced nodes are reclaimed by epochs once
+// no reader can still hold them. Splits are two-step: a split delta on the
+// full page redirects keys at or above the separator to the new sibling,
+// then an index-entry delta posts the sibling to the parent. Readers follow
+// split deltas and right links in between, so no step ever blocks.
+//
+// Keys are unique (insert() of a present key returns false). Pages are
+// never merged; pages emptied by removes stay in place. T must be default
+// constructible and copyable. Compile with -pthread.
+template <typename T, int NodeCapacity = 64>
+class BwTree {
+    static_assert(NodeCapacity >= 4, "BwTree needs at least 4 entries per node");
+
+    using PageId = uint32_t;
+    static constexpr PageId no_page = UINT32_MAX;
+    static constexpr unsigned chunk_bits = 16;
+    static constexpr size_t chunk_size = size_t(1) << chunk_bits;
+    static constexpr size_t max_chunks = 4096;  // 2^28 pages
+    static constexpr uint16_t consolidate_after = 8;  // Delta chain length
+
+    enum class Kind : uint8_t { Leaf, Inner, Insert, Delete, Split, IndexEntry };
+
+    struct Node {
+        Kind kind;
+        uint8_t level;    // 0 for leaves
+        uint16_t chain;   // Deltas above the base
+        uint32_t count;   // Keys (leaf) or children (inner) of the logical node
+        Node* next;       // Next older record; nullptr for a base node
+
+        Node(Kind k, uint8_t lvl, uint16_t chn, uint32_t cnt, Node* nxt)
+            : kind(k), level(lvl), chain(chn), count(cnt), next(nxt) {}
+    };
+
+    // Base node. Keys >= high (when has_high) live in the right sibling.
+    // Inner nodes route keys in [keys[i-1], keys[i]) to children[i].
+    struct Base : Node {
+        std::vector<T> keys;
+        std::vector<PageId> children;  // Inner only
+        bool has_high = false;
+        T high{};
+        PageId right = no_page;
+
+        Base(Kind k, uint8_t lvl) : Node(k, lvl, 0, 0, nullptr) {}
+    };
+
+    // Insert/Delete: key. Split: keys >= key moved to page. IndexEntry: keys
+    // in [key, high) now route to page.
+    struct Delta : Node {
+        T key;
+        PageId page = no_page;
+        bool has_high = false;
+        T high{};
+
+        Delta(Kind k, const T& delta_key, Node* head, uint32_t cnt)
+            : Node(k, head->level, static_cast<uint16_t>(head->chain + 1), cnt, head), key(delta_key) {}
+    };
+
+    std::unique_ptr<std::atomic<std::atomic<Node*>*>[]> chunks_;
+    std::atomic<PageId> next_page_{0};
+    std::atomic<PageId> root_;
+    PageId first_leaf_;
+    std::atomic<size_t> size_{0};
+    mutable btree_detail::EpochManager epochs_;
+
+    static void delete_node(Node* node) {
+        if (node->kind == Kind::Leaf || node->kind == Kind::Inner) {
+            delete static_cast<Base*>(node);
+        } else {
+            delete static_cast<Delta*>(node);
+        }
+    }
+
+    static void delete_chain(Node* node) {
+        while (node != nullptr) {
+            Node* next = node->next;
+            delete_node(node);
+            node = next;
+        }
+    }
+
+    std::atomic<Node*>& slot(PageId page) const {
+        return chunks_[page >> chunk_bits].load(std::memory_order_acquire)[page & (chunk_size - 1)];
+    }
+
+    PageId allocate_page(Node* node) {
+        PageId page = next_page_.fetch_add(1, std::memory_order_relaxed);
+        size_t chunk = page >> chunk_bits;
+        if (chunk >= max_chunks) {
+            throw std::length_error("BwTree mapping table is full");
+        }
+        if (chunks_[chunk].load(std::memory_order_acquire) == nullptr) {
+            auto* fresh = new std::atomic<Node*>[chunk_size]();
+            std::atomic<Node*>* expected = nullptr;
+            if (!chunks_[chunk].compare_exchange_strong(expected, fresh, std::memory_order_acq_rel)) {
+                delete[] fresh;
+            }
+        }
+        slot(page).store(node, std::memory_order_release);
+        return page;
+    }
+
+    // Where a page sends a key: stay, move right (split or high key), or
+    // descend (inner pages)
+    struct Route {
+        enum { Here, Right, Down } action;
+        PageId page;
+    };
+
+    static Route route(const Node* head, const T& key) {
+        for (const Node* node = head; node != nullptr; node = node->next) {
+            switch (node->kind) {
+                case Kind::Split: {
+                    auto* d = static_cast<const Delta*>(node);
+                    if (!(key < d->key)) {
+                        return {Route::Right, d->page};
+                    }
+                    break;
+                }
+                case Kind::IndexEntry: {
+                    auto* d = static_cast<const Delta*>(node);
+                    if (!(key < d->key) && (!d->has_high || key < d->high)) {
+                        return {Route::Down, d->page};
+                    }
+                    break;
+                }
+                case Kind::Leaf:
+                case Kind::Inner: {
+                    auto* b = static_cast<const Base*>(node);
+                    if (b->has_high && !(key < b->high)) {
+                        return {Route::Right, b->right};
+                    }
+                    if (b->kind == Kind::Leaf) {
+                        return {Route::Here, no_page};
+                    }
+                    size_t i = btree_detail::upper_bound_index(b->keys.data(), b->keys.size(), key);
+                    return {Route::Down, b->children[i]};
+                }
+                default:
+                    break;
+            }
+        }
+        return {Route::Here, no_page};
+    }
+
+    // Page at the given level whose key range covers key, with the chain
+    // head that was checked. Requires an epoch guard.
+    std::pair<PageId, Node*> descend(const T& key, uint8_t level) const {
+        while (true) {
+            PageId page = root_.load(std::memory_order_acquire);
+            Node* head = slot(page).load(std::memory_order_acquire);
+            if (head->level < level) {
+                std::this_thread::yield();  // A root split is being posted
+                continue;
+            }
+            while (true) {
+                if (head->level == level) {
+                    // Only moves right are relevant at the target level
+                    Route r = route_here(head, key);
+                    if (r.action == Route::Here) {
+                        return {page, head};
+                    }
+                    page = r.page;
+                } else {
+                    Route r = route(head, key);
+                    page = r.page;
+                }
+                head = slot(page).load(std::memory_order_acquire);
+            }
+        }
+    }
+
+    // Like route(), but only reports moves to a right sibling
+    static Route route_here(const Node* head, const T& key) {
+        for (const Node* node = head; node != nullptr; node = node->next) {
+            if (node->kind == Kind::Split) {
+                auto* d = static_cast<const Delta*>(node);
+                if (!(key < d->key)) {
+                    return {Route::Right, d->page};
+                }
+            } else if (node->kind == Kind::Leaf || node->kind == Kind::Inner) {
+                auto* b = static_cast<const Base*>(node);
+                if (b->has_high && !(key < b->high)) {
+                    return {Route::Right, b->right};
+                }
+            }
+        }
+        return {Route::Here, no_page};
+    }
+
+    // Whether key is present in a leaf chain that covers it
+    static bool leaf_contains(const Node* head, const T& key) {
+        for (const Node* node = head; node != nullptr; node = node->next) {
+            if (node->kind == Kind::Insert || node->kind == Kind::Delete) {
+                auto* d = static_cast<const Delta*>(node);
+                if (d->key == key) {
+                    return node->kind == Kind::Insert;
+                }
+            } else if (node->kind == Kind::Leaf) {
+                auto* b = static_cast<const Base*>(node);
+                size_t i = btree_detail::lower_bound_index(b->keys.data(), b->keys.size(), key);
+                return i < b->keys.size() && b->keys[i] == key;
+            }
+        }
+        return false;
+    }
+
+    // A new base node equal to the chain's logical contents
+    static Base* materialize(const Node* head) {
+        std::vector<const Node*> deltas;
+        const Node* node = head;
+        while (node->kind != Kind::Leaf && node->kind != Kind::Inner) {
+            deltas.push_back(node);
+            node = node->next;
+        }
+        auto* old_base = static_cast<const Base*>(node);
+        auto* base = new Base(old_base->kind, old_base->level);
+        base->keys = old_base->keys;
+        base->children = old_base->children;
+        base->has_high = old_base->has_high;
+        base->high = old_base->high;
+        base->right = old_base->right;
+
+        // Replay oldest first
+        for (auto it = deltas.rbegin(); it != deltas.rend(); ++it) {
+            auto* d = static_cast<const Delta*>(*it);
+            size_t i = btree_detail::lower_bound_index(base->keys.data(), base->keys.size(), d->key);
+            switch (d->kind) {
+                case Kind::Insert:
+                    base->keys.insert(base->keys.begin() + i, d->key);
+                    break;
+                case Kind::Delete:
+                    if (i < base->keys.size() && base->keys[i] == d->key) {
+                        base->keys.erase(base->keys.begin() + i);
+                    }
+                    break;
+                case Kind::Split:
+                    base->keys.resize(i);
+                    if (base->kind == Kind::Inner) {
+                        base->children.resize(i + 1);
+                    }
+                    base->has_high = true;
+                    base->high = d->key;
+                    base->right = d->page;
+                    break;
+                case Kind::IndexEntry:
+                    base->keys.insert(base->keys.begin() + i, d->key);
+                    base->children.insert(base->children.begin() + i + 1, d->page);
+                    break;
+                default:
+                    break;
+            }
+        }
+        base->count = static_cast<uint32_t>(base->kind == Kind::Leaf ? base->keys.size() : base->children.size());
+        return base;
+    }
+
+    void consolidate(PageId page) {
+        Node* head = slot(page).load(std::memory_order_acquire);
+        if (head->chain == 0) {
+            return;
+        }
+        Base* base = materialize(head);
+        if (slot(page).compare_exchange_strong(head, base, std::memory_order_acq_rel)) {
+            epochs_.retire(head, [](void* chain) { delete_chain(static_cast<Node*>(chain)); });
+        } else {
+            delete base;  // Another update won; it will consolidate later
+        }
+    }
+
+    // Split a page that has grown past capacity: create the right half as a
+    // new page, install a split delta, then post the new page to the parent
+    void split(PageId page) {
+        Node* head = slot(page).load(std::memory_order_acquire);
+        if (head->count <= static_cast<uint32_t>(NodeCapacity)) {
+            return;
+        }
+        std::unique_ptr<Base> view(materialize(head));
+        bool leaf = view->kind == Kind::Leaf;
+        size_t mid = view->keys.size() / 2;
+        T separator = view->keys[mid];
+
+        auto* right = new Base(view->kind, view->level);
+        if (leaf) {
+            right->keys.assign(view->keys.begin() + mid, view->keys.end());
+        } else {
+            // The separator moves up; it is not kept in either half
+            right->keys.assign(view->keys.begin() + mid + 1, view->keys.end());
+            right->children.assign(view->children.begin() + mid + 1, view->children.end());
+        }
+        right->count = static_cast<uint32_t>(leaf ? right->keys.size() : right->children.size());
+        right->has_high = view->has_high;
+        right->high = view->high;
+        right->right = view->right;
+        PageId right_page = allocate_page(right);
+
+        auto* split_delta = new Delta(Kind::Split, separator, head, static_cast<uint32_t>(leaf ? mid : mid + 1));
+        split_delta->page = right_page;
+        if (!slot(page).compare_exchange_strong(head, split_delta, std::memory_order_acq_rel)) {
+            // Lost to a concurrent update; the page id is simply never used
+            slot(right_page).store(nullptr, std::memory_order_relaxed);
+            delete right;
+            delete split_delta;
+            return;
+        }
+        post_index_entry(page, view->level, separator, view->has_high, view->high, right_page);
+    }
+
+    void post_index_entry(PageId left, uint8_t level, const T& separator, bool has_high, const T& high,
+                          PageId right) {
+        while (true) {
+            PageId root = root_.load(std::memory_order_acquire);
+            if (root == left) {
+                // Grow a new root over the two halves
+                auto* new_root = new Base(Kind::Inner, static_cast<uint8_t>(level + 1));
+                new_root->keys.push_back(separator);
+                new_root->children = {left, right};
+                new_root->count = 2;
+                PageId root_page = allocate_page(new_root);
+                if (root_.compare_exchange_strong(root, root_page, std::memory_order_acq_rel)) {
+                    return;
+                }
+                slot(root_page).store(nullptr, std::memory_order_relaxed);
+                delete new_root;
+                continue;
+            }
+
+            auto [parent, head] = descend(separator, static_cast<uint8_t>(level + 1));
+            auto* entry = new Delta(Kind::IndexEntry, separator, head, head->count + 1);
+            entry->page = right;
+            entry->has_high = has_high;
+            entry->high = high;
+            if (slot(parent).compare_exchange_strong(head, entry, std::memory_order_acq_rel)) {
+                after_update(parent, entry);
+                return;
+            }
+            delete entry;
+        }
+    }
+
+    void after_update(PageId page, const Node* head) {
+        if (head->count > static_cast<uint32_t>(NodeCapacity)) {
+            split(page);
+        } else if (head->chain >= consolidate_after) {
+            consolidate(page);
+        }
+    }
+
+    // Prepend an insert or delete delta to the leaf covering key. Returns
+    // false (without changing anything) if the key's presence already
+    // matches the request.
+    bool update_leaf(Kind kind, const T& key) {
+        auto guard = epochs_.enter();
+        while (true) {
+            auto [page, head] = descend(key, 0);
+            bool present = leaf_contains(head, key);
+            if (present == (kind == Kind::Insert)) {
+                return false;
+            }
+            uint32_t count = kind == Kind::Insert ? head->count + 1 : head->count - 1;
+            auto* delta = new Delta(kind, key, head, count);
+            if (slot(page).compare_exchange_strong(head, delta, std::memory_order_acq_rel)) {
+                after_update(page, delta);
+                return true;
+            }
+            delete delta;
+        }
+    }
+
+    // Scans leaf by leaf. Each leaf is read from one chain head, so the
+    // keys returned from it are an atomic snapshot of that leaf (a
+    // consistent version, never torn by a concurrent update); different
+    // leaves are read at different times. Only the read runs inside an
+    // epoch guard, so a long scan (or a slow f) never holds back
+    // reclamation. The next leaf is entered at the previous leaf's high key
+    // and, if it has split since, moved right from there, so the scan
+    // resumes exactly after the last key returned. A null from starts at
+    // the first leaf.
+    template <typename Func>
+    size_t scan_leaves(const T* from, size_t limit, Func& f) const {
+        std::vector<T> batch;
+        size_t visited = 0;
+        bool bounded = from != nullptr;
+        T cursor = bounded ? *from : T{};  // Inclusive lower bound of the next leaf
+        PageId page = bounded ? no_page : first_leaf_;
+        while (visited < limit) {
+            bool more;
+            {
+                auto guard = epochs_.enter();
+                Node* head;
+                if (page == no_page) {
+                    std::tie(page, head) = descend(cursor, 0);
+                } else {
+                    head = slot(page).load(std::memory_order_acquire);
+                    while (bounded) {
+                        Route r = route_here(head, cursor);
+                        if (r.action != Route::Right) {
+                            break;
+                        }
+                        page = r.page;
+                        head = slot(page).load(std::memory_order_acquire);
+                    }
+                }
+                std::unique_ptr<Base> leaf(materialize(head));
+                const std::vector<T>& keys = leaf->keys;
+                size_t first = bounded ? btree_detail::lower_bound_index(keys.data(), keys.size(), cursor) : 0;
+                size_t last = std::min(keys.size(), first + (limit - visited));
+                batch.assign(keys.begin() + first, keys.begin() + last);
+                more = leaf->has_high;
+                if (more) {
+                    cursor = leaf->high;
+                    bounded = true;
+                    page = leaf->right;
+                }
+            }
+            for (const T& key : batch) {
+                f(key);
+            }
+            visited += batch.size();
+            if (!more) {
+                break;
+            }
+        }
+        return visited;
+    }
+
+public:
+    BwTree() : chunks_(new std::atomic<std::atomic<Node*>*>[max_chunks]()) {
+        first_leaf_ = allocate_page(new Base(Kind::Leaf, 0));
+        root_.store(first_leaf_, std::memory_order_release);
+    }
+
+    ~BwTree() {
+        PageId pages = std::min<PageId>(next_page_.load(), static_cast<PageId>(max_chunks * chunk_size));
+        for (PageId page = 0; page < pages; page++) {
+            delete_chain(slot(page).load(std::memory_order_relaxed));
+        }
+        for (size_t c = 0; c < max_chunks; c++) {
+            delete[] chunks_[c].load(std::memory_order_relaxed);
+        }
+    }
+
+    BwTree(const BwTree&) = delete;
+    BwTree& operator=(const BwTree&) = delete;
+
+    // Returns false if key was already present
+    bool insert(const T& key) {
+        if (!update_leaf(Kind::Insert, key)) {
+            return false;
+        }
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Returns true if key was present and removed
+    bool remove(const T& key) {
+        if (!update_leaf(Kind::Delete, key)) {
+            return false;
+        }
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool contains(const T& key) const {
+        auto guard = epochs_.enter();
+        return leaf_contains(descend(key, 0).second, key);
+    }
+
+    // Exact when no updates are in flight
+    size_t size() const noexcept { return size_.load(std::memory_order_relaxed); }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    // Calls f(key) for up to limit keys >= from, in order. Returns the
+    // number of keys visited.
+    template <typename Func>
+    size_t scan(const T& from, size_t limit, Func f) const {
+        return scan_leaves(&from, limit, f);
+    }
+
+    // Applies f to every key in order, as scan() from the smallest key
+    template <typename Func>
+    void for_each(Func f) const {
+        scan_leaves(nullptr, SIZE_MAX, f);
+    }
+
+    // Levels from the root to the leaves
+    size_t height() const {
+        auto guard = epochs_.enter();
+        return slot(root_.load(std::memory_order_acquire)).load(std::memory_order_acquire)->level + 1u;
+    }
+};